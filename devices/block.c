@@ -2,6 +2,7 @@
 
 #include "devices/ide.h"
 #include "threads/malloc.h"
+#include "threads/trace.h"
 
 #include <list.h>
 #include <stdio.h>
@@ -115,6 +116,7 @@ static void check_sector(struct block* block, block_sector_t sector)
 void block_read(struct block* block, block_sector_t sector, void* buffer)
 {
 	check_sector(block, sector);
+	TRACE(TRACE_BLOCK_READ, sector, block->type);
 	block->ops->read(block->aux, sector, buffer);
 	block->read_cnt++;
 }
@@ -128,6 +130,7 @@ void block_write(struct block* block, block_sector_t sector, const void* buffer)
 {
 	check_sector(block, sector);
 	ASSERT(block->type != BLOCK_FOREIGN);
+	TRACE(TRACE_BLOCK_WRITE, sector, block->type);
 	block->ops->write(block->aux, sector, buffer);
 	block->write_cnt++;
 }
@@ -70,7 +70,9 @@ struct channel {
 	struct lock lock;						 /* Must acquire to access the controller. */
 	bool expecting_interrupt;			 /* True if an interrupt is expected, false if
 													 any interrupt would be spurious. */
-	struct semaphore completion_wait; /* Up'd by interrupt handler. */
+	struct semaphore completion_wait; /* Up'd by completion softirq. */
+	unsigned completions;				 /* Completions not yet passed to
+													 completion_wait. */
 
 	struct ata_disk devices[2]; /* The devices on this channel. */
 };
@@ -96,12 +98,14 @@ static void select_device(const struct ata_disk*);
 static void select_device_wait(const struct ata_disk*);
 
 static void interrupt_handler(struct intr_frame*);
+static softirq_func completion_softirq;
 
 /* Initialize the disk subsystem and detect disks. */
 void ide_init(void)
 {
 	size_t chan_no;
 
+	intr_register_softirq(SOFTIRQ_BLOCK, completion_softirq, "ide");
 	for (chan_no = 0; chan_no < CHANNEL_CNT; chan_no++) {
 		struct channel* c = &channels[chan_no];
 		int dev_no;
@@ -120,9 +124,10 @@ void ide_init(void)
 			default:
 				NOT_REACHED();
 		}
-		lock_init(&c->lock);
+		lock_init_named(&c->lock, c->name);
 		c->expecting_interrupt = false;
 		sema_init(&c->completion_wait, 0);
+		c->completions = 0;
 
 		/* Initialize devices. */
 		for (dev_no = 0; dev_no < 2; dev_no++) {
@@ -472,8 +477,9 @@ static void interrupt_handler(struct intr_frame* f)
 	for (c = channels; c < channels + CHANNEL_CNT; c++)
 		if (f->vec_no == c->irq) {
 			if (c->expecting_interrupt) {
-				inb(reg_status(c));				/* Acknowledge interrupt. */
-				sema_up(&c->completion_wait); /* Wake up waiter. */
+				inb(reg_status(c)); /* Acknowledge interrupt. */
+				c->completions++;	  /* Wake up waiter in the softirq. */
+				intr_raise_softirq(SOFTIRQ_BLOCK);
 			}
 			else
 				printf("%s: unexpected interrupt\n", c->name);
@@ -482,3 +488,19 @@ static void interrupt_handler(struct intr_frame* f)
 
 	NOT_REACHED();
 }
+
+/* Block softirq.  Wakes up the threads waiting for the requests
+	that interrupt_handler() saw complete. */
+static void completion_softirq(void)
+{
+	struct channel* c;
+
+	for (c = channels; c < channels + CHANNEL_CNT; c++) {
+		enum intr_level old_level = intr_disable();
+		unsigned completions = c->completions;
+		c->completions = 0;
+		intr_set_level(old_level);
+
+		while (completions-- > 0) sema_up(&c->completion_wait);
+	}
+}
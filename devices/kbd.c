@@ -130,6 +130,12 @@ static void keyboard_interrupt(struct intr_frame* args UNUSED)
 			if (c == 0177 && ctrl && alt)
 				shutdown_reboot();
 
+			/* Print interrupt statistics if Ctrl+Alt+I pressed. */
+			if (c == 'I' && ctrl && alt) {
+				intr_print_stats();
+				return;
+			}
+
 			/* Handle Ctrl, Shift.
 				Note that Ctrl overrides Shift. */
 			if (ctrl && c >= 0x40 && c < 0x60) {
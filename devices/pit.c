@@ -13,9 +13,6 @@
 #define PIT_PORT_CONTROL			 0x43					  /* Control port. */
 #define PIT_PORT_COUNTER(CHANNEL) (0x40 + (CHANNEL)) /* Counter port. */
 
-/* PIT cycles per second. */
-#define PIT_HZ 1193180
-
 /* Configure the given CHANNEL in the PIT.  In a PC, the PIT's
 	three output channels are hooked up like this:
 
@@ -80,3 +77,45 @@ void pit_configure_channel(int channel, int mode, int frequency)
 	outb(PIT_PORT_COUNTER(channel), count >> 8);
 	intr_set_level(old_level);
 }
+
+/* Configures channel 0 of the PIT for a single interrupt after
+	COUNT PIT cycles, that is, COUNT / PIT_HZ seconds.  This is
+	mode 0, "interrupt on terminal count": the channel's output
+	rises once when the count reaches 0 and then stays high, so
+	exactly one interrupt is raised.  Afterward the counter keeps
+	counting down, wrapping around from 0 to 0xffff, which lets
+	pit_read_counter() measure how long ago the count expired.
+
+	A COUNT of 0 is treated by the PIT as 65536. */
+void pit_configure_oneshot(int channel, uint16_t count)
+{
+	enum intr_level old_level;
+
+	ASSERT(channel == 0);
+
+	old_level = intr_disable();
+	outb(PIT_PORT_CONTROL, (channel << 6) | 0x30);
+	outb(PIT_PORT_COUNTER(channel), count);
+	outb(PIT_PORT_COUNTER(channel), count >> 8);
+	intr_set_level(old_level);
+}
+
+/* Returns the current value of CHANNEL's counter, which counts
+	down once per PIT cycle. */
+uint16_t pit_read_counter(int channel)
+{
+	enum intr_level old_level;
+	uint8_t lo, hi;
+
+	ASSERT(channel == 0 || channel == 2);
+
+	/* Latch the counter so that both bytes come from the same
+		instant. */
+	old_level = intr_disable();
+	outb(PIT_PORT_CONTROL, channel << 6);
+	lo = inb(PIT_PORT_COUNTER(channel));
+	hi = inb(PIT_PORT_COUNTER(channel));
+	intr_set_level(old_level);
+
+	return lo | (hi << 8);
+}
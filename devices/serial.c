@@ -56,10 +56,16 @@ static enum { UNINIT, POLL, QUEUE } mode;
 /* Data to be transmitted. */
 static struct intq txq;
 
+/* True while the serial softirq is pending.  The transmit
+	interrupt stays off meanwhile, since the UART would otherwise
+	raise it again as soon as interrupts come back on. */
+static bool xmit_softirq_pending;
+
 static void set_serial(int bps);
 static void putc_poll(uint8_t);
 static void write_ier(void);
 static intr_handler_func serial_interrupt;
+static softirq_func serial_softirq;
 
 /* Initializes the serial port device for polling mode.
 	Polling mode busy-waits for the serial port to become free
@@ -88,6 +94,7 @@ void serial_init_queue(void)
 	ASSERT(mode == POLL);
 
 	intr_register_ext(0x20 + 4, serial_interrupt, "serial");
+	intr_register_softirq(SOFTIRQ_SERIAL, serial_softirq, "serial");
 	mode = QUEUE;
 	old_level = intr_disable();
 	write_ier();
@@ -109,8 +116,9 @@ void serial_putc(uint8_t byte)
 	else {
 		/* Otherwise, queue a byte and update the interrupt enable
 			register. */
-		if (old_level == INTR_OFF && intq_full(&txq)) {
-			/* Interrupts are off and the transmit queue is full.
+		if ((old_level == INTR_OFF || intr_context()) && intq_full(&txq)) {
+			/* Interrupts are off, or we are in a softirq, which
+				may not sleep, and the transmit queue is full.
 				If we wanted to wait for the queue to empty,
 				we'd have to reenable interrupts.
 				That's impolite, so we'll send a character via
@@ -172,8 +180,9 @@ static void write_ier(void)
 	ASSERT(intr_get_level() == INTR_OFF);
 
 	/* Enable transmit interrupt if we have any characters to
-		transmit. */
-	if (!intq_empty(&txq))
+		transmit and the softirq is not already on its way to
+		transmit them. */
+	if (!intq_empty(&txq) && !xmit_softirq_pending)
 		ier |= IER_XMIT;
 
 	/* Enable receive interrupt if we have room to store any
@@ -205,11 +214,31 @@ static void serial_interrupt(struct intr_frame* f UNUSED)
 		has a byte for us, receive a byte.  */
 	while (!input_full() && (inb(LSR_REG) & LSR_DR) != 0) input_putc(inb(RBR_REG));
 
-	/* As long as we have a byte to transmit, and the hardware is
-		ready to accept a byte for transmission, transmit a byte. */
-	while (!intq_empty(&txq) && (inb(LSR_REG) & LSR_THRE) != 0)
+	/* Leave transmission to the serial softirq. */
+	if (!intq_empty(&txq) && !xmit_softirq_pending) {
+		xmit_softirq_pending = true;
+		intr_raise_softirq(SOFTIRQ_SERIAL);
+	}
+
+	/* Update interrupt enable register based on queue status. */
+	write_ier();
+}
+
+/* Serial softirq.  As long as we have a byte to transmit, and the
+	hardware is ready to accept a byte for transmission, transmits
+	a byte, letting interrupts in between bytes. */
+static void serial_softirq(void)
+{
+	enum intr_level old_level = intr_disable();
+
+	xmit_softirq_pending = false;
+	while (!intq_empty(&txq) && (inb(LSR_REG) & LSR_THRE) != 0) {
 		outb(THR_REG, intq_getc(&txq));
+		intr_set_level(old_level);
+		intr_disable();
+	}
 
 	/* Update interrupt enable register based on queue status. */
 	write_ier();
+	intr_set_level(old_level);
 }
@@ -3,13 +3,18 @@
 #include "devices/kbd.h"
 #include "devices/serial.h"
 #include "devices/timer.h"
+#include "threads/interrupt.h"
 #include "threads/io.h"
+#include "threads/profile.h"
 #include "threads/thread.h"
+#include "threads/trace.h"
+#include "threads/workqueue.h"
 
 #include <console.h>
 #include <stdio.h>
 #ifdef USERPROG
 #include "userprog/exception.h"
+#include "userprog/syscall.h"
 #endif
 #ifdef FILESYS
 #include "devices/block.h"
@@ -123,7 +128,13 @@ void shutdown_power_off(void)
 static void print_stats(void)
 {
 	timer_print_stats();
+	intr_print_stats();
 	thread_print_stats();
+	workqueue_print_stats();
+	profile_print();
+#ifdef LOCK_PROFILE
+	lock_print_stats();
+#endif
 #ifdef FILESYS
 	block_print_stats();
 #endif
@@ -131,5 +142,7 @@ static void print_stats(void)
 	kbd_print_stats();
 #ifdef USERPROG
 	exception_print_stats();
+	syscall_print_stats();
 #endif
+	trace_dump();
 }
@@ -1,7 +1,9 @@
 #include "devices/timer.h"
 
 #include "devices/pit.h"
+#include "threads/cpu.h"
 #include "threads/interrupt.h"
+#include "threads/profile.h"
 #include "threads/synch.h"
 #include "threads/thread.h"
 #include "userprog/process.h"
@@ -19,6 +21,8 @@
 #error TIMER_FREQ <= 1000 recommended
 #endif
 
+/* Interrupt vector of PIT channel 0. */
+#define TIMER_VEC 0x20
 
 /* Number of timer ticks since OS booted. */
 static int64_t ticks;
@@ -27,31 +31,123 @@ static int64_t ticks;
 	Initialized by timer_calibrate(). */
 static unsigned loops_per_tick;
 
+/* Clock based on the CPU's time-stamp counter, which counts clock
+	cycles, calibrated against the timer interrupt by
+	timer_calibrate().  A TSC reading C is tsc_ns_base + (C -
+	tsc_base) * tsc_mult / 2**tsc_shift nanoseconds since boot.
+	tsc_shift is chosen as large as possible with tsc_mult still
+	fitting in 32 bits, so the conversion takes two 32x32-bit
+	multiplications and no division.
+
+	This assumes that the TSC runs at a constant rate, as it does
+	on processors since about 2008 and in emulators. */
+#define TSC_CALIBRATE_TICKS 10 /* Ticks to count cycles over. */
+static uint64_t tsc_hz;			 /* Cycles per second, 0 until calibrated. */
+static uint64_t tsc_base;		 /* TSC at calibration. */
+static int64_t tsc_ns_base;	 /* Nanoseconds since boot at calibration. */
+static uint32_t tsc_mult;
+static int tsc_shift;
+
 static intr_handler_func timer_interrupt;
 static bool too_many_loops(unsigned loops);
 static void busy_wait(int64_t loops);
 static void real_time_sleep(int64_t num, int32_t denom);
 static void real_time_delay(int64_t num, int32_t denom);
-
-/* List to keep track of sleeping threads */
-static struct list sleeping_threads;
-
-/* Function to compare wakeup ticks for ordering in the list */
-static bool compare_wakeup_ticks(const struct list_elem *a, const struct list_elem *b, void *aux) {
-    return list_entry(a, struct thread, elem)->wakeup_ticks < list_entry(b, struct thread, elem)->wakeup_ticks;
-}
+static void tsc_calibrate(void);
+
+/* Hierarchical timing wheel holding every pending struct timer.
+
+	Level 0 has one slot per tick for the next WHEEL_SLOTS ticks.
+	Each slot of level N covers WHEEL_SLOTS^N ticks, so the whole
+	wheel spans WHEEL_SLOTS^WHEEL_LEVELS ticks.  A timer is placed
+	in the lowest level whose range covers its expiry, which makes
+	timer_add() and timer_cancel() O(1).  Whenever level 0 wraps
+	around, the next slot of level 1 is "cascaded", that is, its
+	timers are re-added and so spread out over level 0, and
+	likewise for higher levels.  Each timer is cascaded at most
+	once per level, so expiry is amortized O(1) per timer.
+
+	Timers further out than the wheel spans are parked in the
+	farthest slot of the top level and simply placed again when
+	that slot is cascaded.
+
+	Accessed only with interrupts off. */
+#define WHEEL_BITS 6								 /* Log2 of slots per level. */
+#define WHEEL_SLOTS (1 << WHEEL_BITS)		 /* Slots per level. */
+#define WHEEL_MASK (WHEEL_SLOTS - 1)
+#define WHEEL_LEVELS 4								 /* Number of levels. */
+#define WHEEL_SPAN (1 << (WHEEL_BITS * WHEEL_LEVELS)) /* Ticks covered. */
+static struct list wheel[WHEEL_LEVELS][WHEEL_SLOTS];
+
+/* Next tick whose level-0 slot has not yet been run. */
+static int64_t wheel_next;
+
+static void wheel_insert(struct timer*);
+static void wheel_cascade(int level);
+static void wheel_run(void);
+static void wake_sleeper(struct timer*, void* thread);
+static int64_t wheel_next_expiry(void);
+
+/* If false (default), the PIT interrupts periodically, once per
+	tick.  If true, it is reprogrammed in one-shot mode for each
+	interrupt, which lets the idle thread skip ticks and lets
+	timer_hrsleep() wake threads between ticks.  Controlled by
+	kernel command-line option "-tickless". */
+bool timer_tickless;
+
+/* One-shot mode.  The PIT clock, in PIT cycles since boot, is
+	pit_clock at the time the count pit_loaded was last loaded
+	into the PIT plus however far it has since counted down.
+	Ticks happen at multiples of TICK_CYCLES on this clock. */
+#define TICK_CYCLES ((PIT_HZ + TIMER_FREQ / 2) / TIMER_FREQ)
+#define ONESHOT_MIN_CYCLES 20	/* Shortest one-shot interval. */
+#define ONESHOT_MAX_CYCLES 0x8000 /* Longest one-shot interval. */
+#define HRSLEEP_MIN_CYCLES 1193 /* Shorter sleeps busy-wait (1 ms). */
+static int64_t pit_clock;
+static uint16_t pit_loaded;
+static int64_t pit_clock_last; /* Latest value of pit_clock_now(). */
+static bool idle_stopped; /* Tick stopped by timer_idle_enter()? */
+
+/* Threads in timer_hrsleep() waiting for a deadline less than
+	a tick away, ordered by deadline. */
+struct hr_sleeper {
+	int64_t deadline;		  /* PIT clock at which to wake. */
+	struct thread* thread; /* Sleeping thread. */
+	struct list_elem elem; /* Element in hr_sleepers. */
+};
+static struct list hr_sleepers;
+
+static int64_t pit_clock_now(void);
+static void oneshot_program_next(void);
+static void hr_run(void);
 
 /* Sets up the timer to interrupt TIMER_FREQ times per second,
 	and registers the corresponding interrupt. */
 void timer_init(const uint16_t timer_freq)
 {
 	//TIMER_FREQ = timer_freq;
-	pit_configure_channel(0, 2, TIMER_FREQ);
-	intr_register_ext(0x20, timer_interrupt, "8254 Timer");
-	list_init(&sleeping_threads);
+	int level, slot;
+
+	for (level = 0; level < WHEEL_LEVELS; level++)
+		for (slot = 0; slot < WHEEL_SLOTS; slot++) list_init(&wheel[level][slot]);
+	wheel_next = ticks + 1;
+	list_init(&hr_sleepers);
+
+	intr_register_ext(TIMER_VEC, timer_interrupt, "8254 Timer");
+	intr_register_softirq(SOFTIRQ_TIMER, wheel_run, "timer");
+	if (timer_tickless) {
+		enum intr_level old_level = intr_disable();
+		pit_clock = ticks * TICK_CYCLES;
+		pit_loaded = pit_read_counter(0);
+		oneshot_program_next();
+		intr_set_level(old_level);
+	}
+	else
+		pit_configure_channel(0, 2, TIMER_FREQ);
 }
 
-/* Calibrates loops_per_tick, used to implement brief delays. */
+/* Calibrates loops_per_tick, used to implement brief delays,
+	and the TSC clock. */
 void timer_calibrate(void)
 {
 	unsigned high_bit, test_bit;
@@ -73,7 +169,42 @@ void timer_calibrate(void)
 		if (!too_many_loops(loops_per_tick | test_bit))
 			loops_per_tick |= test_bit;
 
-	printf("%'" PRIu64 " loops/s.\n", (uint64_t) loops_per_tick * TIMER_FREQ);
+	tsc_calibrate();
+	printf(
+		 "%'" PRIu64 " loops/s, %'" PRIu64 " TSC cycles/s.\n",
+		 (uint64_t) loops_per_tick * TIMER_FREQ,
+		 tsc_hz);
+}
+
+/* Counts TSC cycles over TSC_CALIBRATE_TICKS timer ticks and sets
+	up the conversion from cycles to nanoseconds. */
+static void tsc_calibrate(void)
+{
+	int64_t start;
+	uint64_t tsc_start, hz;
+	enum intr_level old_level;
+
+	/* Start and end right after a tick, when the interrupt
+		latency is the same at both ends and the PIT counter is
+		far from wrapping around. */
+	start = timer_ticks();
+	while (timer_ticks() == start) barrier();
+	start = timer_ticks();
+	tsc_start = rdtsc();
+	while (timer_ticks() < start + TSC_CALIBRATE_TICKS) barrier();
+
+	old_level = intr_disable();
+	tsc_base = rdtsc();
+	tsc_ns_base = pit_clock_now() * 1000000000 / PIT_HZ;
+	hz = (tsc_base - tsc_start) * TIMER_FREQ / TSC_CALIBRATE_TICKS;
+	if (hz != 0) {
+		for (tsc_shift = 32; tsc_shift > 0; tsc_shift--)
+			if (((uint64_t) 1000000000 << tsc_shift) / hz <= UINT32_MAX)
+				break;
+		tsc_mult = ((uint64_t) 1000000000 << tsc_shift) / hz;
+		tsc_hz = hz;
+	}
+	intr_set_level(old_level);
 }
 
 /* Returns the number of timer ticks since the OS booted. */
@@ -92,25 +223,210 @@ int64_t timer_elapsed(int64_t then)
 	return timer_ticks() - then;
 }
 
+/* Returns the number of microseconds since the OS booted.  Unlike
+	timer_ticks(), this can time intervals much shorter than a
+	tick. */
+int64_t timer_clock_us(void)
+{
+	return timer_ns() / 1000;
+}
+
+/* Returns the number of nanoseconds since the OS booted, read
+	from the TSC.  This is cheap enough to time individual system
+	calls or context switches.  Until timer_calibrate() has run,
+	it has only the resolution of the PIT. */
+int64_t timer_ns(void)
+{
+	if (tsc_hz == 0) {
+		enum intr_level old_level = intr_disable();
+		int64_t cycles = pit_clock_now();
+		intr_set_level(old_level);
+		return cycles * 1000000000 / PIT_HZ;
+	}
+	return tsc_ns_base + timer_cycles_to_ns(rdtsc() - tsc_base);
+}
+
+/* Returns the CPU's time-stamp counter, in clock cycles.  Use
+	timer_cycles_to_ns() to convert a difference between two
+	readings to time. */
+uint64_t timer_cycles(void)
+{
+	return rdtsc();
+}
+
+/* Converts CYCLES TSC cycles to nanoseconds.  Returns 0 until
+	timer_calibrate() has run. */
+uint64_t timer_cycles_to_ns(uint64_t cycles)
+{
+	uint64_t hi = cycles >> 32;
+	uint64_t lo = cycles & UINT32_MAX;
+
+	return ((hi * tsc_mult) << (32 - tsc_shift)) + ((lo * tsc_mult) >> tsc_shift);
+}
+
+/* Initializes TIMER to call FUNC, passing AUX, when it expires.
+	The timer is not armed until passed to timer_add(). */
+void timer_setup(struct timer* timer, timer_func* func, void* aux)
+{
+	ASSERT(timer != NULL);
+	ASSERT(func != NULL);
+
+	timer->expires = 0;
+	timer->func = func;
+	timer->aux = aux;
+	timer->pending = false;
+}
+
+/* Arms TIMER to fire at tick EXPIRES, as returned by
+	timer_ticks().  If EXPIRES has already passed, TIMER fires at
+	the next tick.  TIMER must not already be pending.
+
+	May be called from an interrupt handler, including from a
+	timer function. */
+void timer_add(struct timer* timer, int64_t expires)
+{
+	enum intr_level old_level;
+
+	ASSERT(timer != NULL);
+	ASSERT(timer->func != NULL);
+
+	old_level = intr_disable();
+	ASSERT(!timer->pending);
+	timer->expires = expires;
+	timer->pending = true;
+	wheel_insert(timer);
+	intr_set_level(old_level);
+}
+
+/* Disarms TIMER.  Returns true if TIMER was pending, false if it
+	had already fired or was never armed.
+
+	May be called from an interrupt handler. */
+bool timer_cancel(struct timer* timer)
+{
+	enum intr_level old_level;
+	bool was_pending;
+
+	ASSERT(timer != NULL);
+
+	old_level = intr_disable();
+	was_pending = timer->pending;
+	if (was_pending) {
+		list_remove(&timer->elem);
+		timer->pending = false;
+	}
+	intr_set_level(old_level);
+
+	return was_pending;
+}
+
+/* Returns true if TIMER is armed and has not yet fired. */
+bool timer_pending(const struct timer* timer)
+{
+	return timer->pending;
+}
+
 /* Sleeps for approximately TICKS timer ticks.  Interrupts must
 	be turned on. */
 void timer_sleep(int64_t ticks)
 {
-	int64_t start = timer_ticks();
-    ASSERT(intr_get_level() == INTR_ON);
+	struct timer timer;
+	enum intr_level old_level;
 
-    struct thread *current_thread = thread_current();
-    current_thread->wakeup_ticks = start + ticks;
+	ASSERT(intr_get_level() == INTR_ON);
+
+	if (ticks <= 0)
+		return;
 
-    list_insert_ordered(&sleeping_threads, &current_thread->elem,
-                        (list_less_func *)&compare_wakeup_ticks, NULL);
+	/* Arm the wakeup and block atomically, so that the timer
+		cannot fire before we are blocked. */
+	timer_setup(&timer, wake_sleeper, thread_current());
+	old_level = intr_disable();
+	timer_add(&timer, timer_ticks() + ticks);
+	thread_block();
+	intr_set_level(old_level);
+}
 
+/* Returns true if hr_sleeper A has an earlier deadline than B. */
+static bool hr_sleeper_less(
+	 const struct list_elem* a_, const struct list_elem* b_, void* aux UNUSED)
+{
+	const struct hr_sleeper* a = list_entry(a_, struct hr_sleeper, elem);
+	const struct hr_sleeper* b = list_entry(b_, struct hr_sleeper, elem);
+
+	return a->deadline < b->deadline;
+}
+
+/* Sleeps for approximately NS nanoseconds, blocking rather than
+	busy-waiting even for intervals shorter than a tick.  Whole
+	ticks are slept on the timing wheel and the remainder on a
+	short list of sub-tick deadlines.  With "-tickless", the PIT
+	is programmed to interrupt at the deadline itself; otherwise
+	the thread wakes at the first tick after it.  Interrupts must
+	be turned on. */
+void timer_hrsleep(int64_t ns)
+{
+	struct hr_sleeper sleeper;
 	enum intr_level old_level;
-    old_level = intr_disable();					
+	int64_t whole_ticks;
 
-    thread_block();
+	ASSERT(intr_get_level() == INTR_ON);
 
-    intr_set_level(old_level);
+	if (ns <= 0)
+		return;
+
+	old_level = intr_disable();
+	sleeper.deadline = pit_clock_now() + ns / 1000000000 * PIT_HZ
+							 + ns % 1000000000 * PIT_HZ / 1000000000;
+	whole_ticks = sleeper.deadline / TICK_CYCLES - ticks - 1;
+	intr_set_level(old_level);
+
+	if (whole_ticks > 0)
+		timer_sleep(whole_ticks);
+
+	old_level = intr_disable();
+	if (pit_clock_now() < sleeper.deadline) {
+		sleeper.thread = thread_current();
+		list_insert_ordered(&hr_sleepers, &sleeper.elem, hr_sleeper_less, NULL);
+		if (timer_tickless)
+			oneshot_program_next();
+		thread_block();
+	}
+	intr_set_level(old_level);
+}
+
+/* Stops the periodic tick while the CPU idles, if running with
+	"-tickless".  The PIT is programmed to interrupt only at the
+	next timer or sub-tick deadline.  Called by the idle thread,
+	with interrupts off, just before it halts. */
+void timer_idle_enter(void)
+{
+	ASSERT(intr_get_level() == INTR_OFF);
+
+	if (!timer_tickless)
+		return;
+	idle_stopped = true;
+	oneshot_program_next();
+}
+
+/* Restarts the tick stopped by timer_idle_enter(), if any.
+	Called at the start of every external interrupt, with its
+	vector VEC, since any of them may make a thread ready to run.
+	The timer interrupt reprograms the PIT itself once it has
+	run, so the PIT is programmed only once per interrupt. */
+void timer_idle_exit(uint8_t vec)
+{
+	if (!idle_stopped)
+		return;
+	idle_stopped = false;
+	if (vec != TIMER_VEC)
+		oneshot_program_next();
+}
+
+/* Timer function used by timer_sleep() to wake THREAD. */
+static void wake_sleeper(struct timer* timer UNUSED, void* thread)
+{
+	thread_unblock(thread);
 }
 
 /* Sleeps for approximately MS milliseconds.  Interrupts must be
@@ -177,24 +493,215 @@ void timer_print_stats(void)
 }
 
 /* Timer interrupt handler. */
-static void timer_interrupt(struct intr_frame* args UNUSED)
+static void timer_interrupt(struct intr_frame* args)
+{
+	if (timer_tickless) {
+		/* A one-shot interrupt may fall between ticks, for a
+			sub-tick deadline, or come after several skipped ones. */
+		int64_t now_ticks = pit_clock_now() / TICK_CYCLES;
+		if (now_ticks > ticks) {
+			if (now_ticks - ticks > 1)
+				thread_ticks_skipped(now_ticks - ticks - 1);
+			ticks = now_ticks;
+			thread_tick();
+			if (profile_interval != 0 && ticks % profile_interval == 0)
+				profile_sample(args);
+		}
+		if (wheel_next <= ticks)
+			intr_raise_softirq(SOFTIRQ_TIMER);
+		hr_run();
+		oneshot_program_next();
+	}
+	else {
+		ticks++;
+		thread_tick();
+		if (profile_interval != 0 && ticks % profile_interval == 0)
+			profile_sample(args);
+		if (wheel_next <= ticks)
+			intr_raise_softirq(SOFTIRQ_TIMER);
+		hr_run();
+	}
+}
+
+/* Returns the PIT clock, in PIT cycles since boot.  Must be
+	called with interrupts off. */
+static int64_t pit_clock_now(void)
+{
+	uint16_t counter = pit_read_counter(0);
+	int64_t now;
+
+	ASSERT(intr_get_level() == INTR_OFF);
+
+	if (!timer_tickless)
+		now = ticks * TICK_CYCLES + (TICK_CYCLES - counter);
+	else {
+		/* The counter wraps from 0 to 0xffff once the one-shot
+			count expires, so 16-bit arithmetic also covers the time
+			since expiry, as long as less than 0x10000 cycles have
+			passed since the count was loaded.  Capping the count at
+			ONESHOT_MAX_CYCLES leaves room for the expiry interrupt
+			to be handled late. */
+		now = pit_clock + (uint16_t) (pit_loaded - counter);
+	}
+
+	/* Once the periodic counter reloads, until the tick's
+		interrupt is handled, `ticks' is one behind the counter and
+		the sum above falls back by a tick.  Never go backward. */
+	if (now < pit_clock_last)
+		now = pit_clock_last;
+	pit_clock_last = now;
+	return now;
+}
+
+/* Programs the PIT in one-shot mode to interrupt at the next
+	event: the next tick, the next sub-tick deadline, or, while
+	the idle thread has stopped the tick, the next timing wheel
+	expiry.  Must be called with interrupts off. */
+static void oneshot_program_next(void)
+{
+	int64_t now = pit_clock_now();
+	int64_t next = (ticks + 1) * TICK_CYCLES;
+	int64_t delta;
+
+	ASSERT(intr_get_level() == INTR_OFF);
+
+	if (idle_stopped) {
+		int64_t expiry = wheel_next_expiry();
+
+		/* The multi-level feedback queue scheduler must see the
+			tick at the start of each second. */
+		if (thread_mlfqs && expiry > ROUND_UP(ticks + 1, TIMER_FREQ))
+			expiry = ROUND_UP(ticks + 1, TIMER_FREQ);
+		if (expiry * TICK_CYCLES > next)
+			next = expiry * TICK_CYCLES;
+	}
+	if (!list_empty(&hr_sleepers)) {
+		int64_t deadline = list_entry(list_front(&hr_sleepers), struct hr_sleeper, elem)->deadline;
+		if (deadline < next)
+			next = deadline;
+	}
+
+	delta = next - now;
+	if (delta < ONESHOT_MIN_CYCLES)
+		delta = ONESHOT_MIN_CYCLES;
+	else if (delta > ONESHOT_MAX_CYCLES)
+		delta = ONESHOT_MAX_CYCLES;
+
+	pit_clock = now;
+	pit_loaded = delta;
+	pit_configure_oneshot(0, delta);
+}
+
+/* Wakes every thread in timer_hrsleep() whose deadline has
+	passed. */
+static void hr_run(void)
+{
+	int64_t now;
+
+	if (list_empty(&hr_sleepers))
+		return;
+
+	now = pit_clock_now();
+	while (!list_empty(&hr_sleepers)) {
+		struct hr_sleeper* s = list_entry(list_front(&hr_sleepers), struct hr_sleeper, elem);
+		if (s->deadline > now)
+			break;
+		list_pop_front(&hr_sleepers);
+		thread_unblock(s->thread);
+	}
+}
+
+/* Returns the first tick at which the timing wheel may have work
+	to do: the tick of the earliest level-0 timer, or else the next
+	time level 0 wraps around and cascades higher levels.  Returns
+	INT64_MAX if the wheel is empty. */
+static int64_t wheel_next_expiry(void)
+{
+	int64_t t;
+	int level, slot;
+
+	for (t = wheel_next; t < wheel_next + WHEEL_SLOTS; t++)
+		if (!list_empty(&wheel[0][t & WHEEL_MASK]))
+			return t;
+
+	for (level = 1; level < WHEEL_LEVELS; level++)
+		for (slot = 0; slot < WHEEL_SLOTS; slot++)
+			if (!list_empty(&wheel[level][slot]))
+				return ROUND_UP(wheel_next, WHEEL_SLOTS);
+	return INT64_MAX;
+}
+
+/* Adds pending TIMER to the slot of the timing wheel that
+	matches its expiry. */
+static void wheel_insert(struct timer* timer)
 {
-	ticks++;
-	thread_tick();
+	int64_t expires = timer->expires;
+	int64_t delta = expires - wheel_next;
+	int level;
 
-	// Check for threads to wake up
-    struct list_elem *e;
-    while (!list_empty(&sleeping_threads)) {
-        e = list_begin(&sleeping_threads);
-        struct thread *t = list_entry(e, struct thread, elem);
+	ASSERT(intr_get_level() == INTR_OFF);
 
-        if (t->wakeup_ticks <= ticks) {
-            list_pop_front(&sleeping_threads);
-            thread_unblock(t);
-        } else {
-            break;  // Stop checking, threads are ordered by wakeup_ticks
-        }
-    }
+	if (delta < 0) {
+		/* Already expired: run at the next tick processed. */
+		expires = wheel_next;
+		delta = 0;
+	}
+	else if (delta >= WHEEL_SPAN) {
+		/* Too far out: park in the farthest slot. */
+		expires = wheel_next + WHEEL_SPAN - 1;
+		delta = WHEEL_SPAN - 1;
+	}
+
+	for (level = 0; delta >= (int64_t) 1 << (WHEEL_BITS * (level + 1)); level++) continue;
+	list_push_back(
+		 &wheel[level][(expires >> (WHEEL_BITS * level)) & WHEEL_MASK], &timer->elem);
+}
+
+/* Re-adds each timer in the current slot of wheel LEVEL, which
+	moves it into a lower level.  If this empties a slot of LEVEL
+	that is itself the start of a new round, cascades the level
+	above first. */
+static void wheel_cascade(int level)
+{
+	struct list* slot;
+	int idx = (wheel_next >> (WHEEL_BITS * level)) & WHEEL_MASK;
+
+	if (idx == 0 && level + 1 < WHEEL_LEVELS)
+		wheel_cascade(level + 1);
+
+	slot = &wheel[level][idx];
+	while (!list_empty(slot)) wheel_insert(list_entry(list_pop_front(slot), struct timer, elem));
+}
+
+/* Runs every timer that expired up to the current tick.  Runs as
+	the timer softirq, which the timer interrupt handler raises
+	when a level-0 slot comes due.  Timer functions are still
+	called with interrupts off. */
+static void wheel_run(void)
+{
+	ASSERT(intr_get_level() == INTR_ON);
+
+	intr_disable();
+	while (wheel_next <= ticks) {
+		struct list* slot = &wheel[0][wheel_next & WHEEL_MASK];
+
+		if ((wheel_next & WHEEL_MASK) == 0)
+			wheel_cascade(1);
+
+		/* Pop timers one at a time, since a timer function may add
+			a timer that lands in this same slot.  Let interrupts in
+			between timers, so that they are off for only one timer
+			function at a time however many expire together. */
+		while (!list_empty(slot)) {
+			struct timer* timer = list_entry(list_pop_front(slot), struct timer, elem);
+			timer->pending = false;
+			timer->func(timer, timer->aux);
+			intr_enable();
+			intr_disable();
+		}
+		wheel_next++;
+	}
+	intr_enable();
 }
 
 /* Returns true if LOOPS iterations waits for more than one timer
@@ -244,6 +751,11 @@ static void real_time_sleep(int64_t num, int32_t denom)
 			processes. */
 		timer_sleep(ticks);
 	}
+	else if (timer_tickless && num * PIT_HZ / denom >= HRSLEEP_MIN_CYCLES) {
+		/* The PIT can interrupt at the deadline itself, so block
+			instead of spinning. */
+		timer_hrsleep(num * (1000000000 / denom));
+	}
 	else {
 		/* Otherwise, use a busy-wait loop for more accurate
 			sub-tick timing. */
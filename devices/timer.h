@@ -1,23 +1,60 @@
 #ifndef DEVICES_TIMER_H
 #define DEVICES_TIMER_H
 
+#include <list.h>
 #include <round.h>
+#include <stdbool.h>
 #include <stdint.h>
 
 /* Number of timer interrupts per second. */
 #define TIMER_FREQ 100
 
+/* If true, use one-shot timer interrupts and stop the tick while
+	idle.  Controlled by kernel command-line option "-tickless". */
+extern bool timer_tickless;
+
+struct timer;
+
+/* Function called when a timer expires.  It runs in the timer
+	softirq with interrupts off, so it must not sleep. */
+typedef void timer_func(struct timer*, void* aux);
+
+/* A one-shot kernel timer.  Owned by the caller, but its members
+	are managed by timer.c. */
+struct timer {
+	int64_t expires;		  /* Tick at which the timer fires. */
+	timer_func* func;		  /* Function to call on expiry. */
+	void* aux;				  /* Auxiliary data for FUNC. */
+	bool pending;			  /* On the timing wheel? */
+	struct list_elem elem; /* Element in a timing wheel slot. */
+};
+
 void timer_init(const uint16_t timer_freq);
 void timer_calibrate(void);
 
 int64_t timer_ticks(void);
 int64_t timer_elapsed(int64_t);
+int64_t timer_clock_us(void);
+int64_t timer_ns(void);
+uint64_t timer_cycles(void);
+uint64_t timer_cycles_to_ns(uint64_t cycles);
+
+/* Cancellable timeouts. */
+void timer_setup(struct timer*, timer_func*, void* aux);
+void timer_add(struct timer*, int64_t expires);
+bool timer_cancel(struct timer*);
+bool timer_pending(const struct timer*);
 
 /* Sleep and yield the CPU to other threads. */
 void timer_sleep(int64_t ticks);
 void timer_msleep(int64_t milliseconds);
 void timer_usleep(int64_t microseconds);
 void timer_nsleep(int64_t nanoseconds);
+void timer_hrsleep(int64_t nanoseconds);
+
+/* Tick stopping while idle. */
+void timer_idle_enter(void);
+void timer_idle_exit(uint8_t vec);
 
 /* Busy waits. */
 void timer_mdelay(int64_t milliseconds);
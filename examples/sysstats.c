@@ -0,0 +1,137 @@
+/* sysstats.c
+
+	Prints a table of system call counts, errors, and times, in
+	the manner of `strace -c'.
+
+	Usage: sysstats [-l] [-p] [COMMAND [ARG...]]
+
+	With a COMMAND, runs it, waits for it, and prints the calls
+	made system-wide meanwhile, which include sysstats's own
+	exec(), wait(), and syscall_stats().  Without one, prints the
+	calls made since boot, or with -p those made by sysstats
+	itself.  -l also prints each call's latency histogram. */
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <syscall.h>
+
+/* Most system call numbers we can report on. */
+#define MAX_CALLS 64
+
+static struct syscall_stat before[MAX_CALLS], after[MAX_CALLS];
+static struct syscall_stat* sorted[MAX_CALLS];
+
+/* Orders statistics by decreasing total time. */
+static int compare_time(const void* a_, const void* b_)
+{
+	const struct syscall_stat* a = *(const struct syscall_stat* const*) a_;
+	const struct syscall_stat* b = *(const struct syscall_stat* const*) b_;
+
+	return a->ns < b->ns ? 1 : a->ns > b->ns ? -1 : 0;
+}
+
+/* Prints the latency histogram of ST. */
+static void print_histogram(const struct syscall_stat* st)
+{
+	int i;
+
+	printf("%-16s", st->name);
+	for (i = 0; i < SYSCALL_HIST_CNT; i++) {
+		if (st->hist[i] == 0)
+			continue;
+		if (i == SYSCALL_HIST_CNT - 1)
+			printf(" >=%dus:%u", 1 << (i - 1), st->hist[i]);
+		else
+			printf(" <%dus:%u", 1 << i, st->hist[i]);
+	}
+	printf("\n");
+}
+
+int main(int argc, char* argv[])
+{
+	bool histograms = false;
+	int scope = STATS_SYSTEM;
+	int cnt, used, i, j;
+	uint64_t total_ns = 0;
+	unsigned total_calls = 0, total_errors = 0;
+
+	for (i = 1; i < argc && argv[i][0] == '-'; i++) {
+		if (!strcmp(argv[i], "-l"))
+			histograms = true;
+		else if (!strcmp(argv[i], "-p"))
+			scope = STATS_PROCESS;
+		else {
+			printf("usage: sysstats [-l] [-p] [COMMAND [ARG...]]\n");
+			return EXIT_FAILURE;
+		}
+	}
+
+	/* Run the command, if any, and take the difference. */
+	if (i < argc) {
+		char cmd_line[128] = "";
+		pid_t pid;
+
+		for (j = i; j < argc; j++) {
+			if (j > i)
+				strlcat(cmd_line, " ", sizeof cmd_line);
+			strlcat(cmd_line, argv[j], sizeof cmd_line);
+		}
+		syscall_stats(scope, before, MAX_CALLS);
+		pid = exec(cmd_line);
+		if (pid == PID_ERROR) {
+			printf("sysstats: %s: exec failed\n", cmd_line);
+			return EXIT_FAILURE;
+		}
+		wait(pid);
+	}
+	cnt = syscall_stats(scope, after, MAX_CALLS);
+	if (cnt < 0) {
+		printf("sysstats: syscall_stats failed\n");
+		return EXIT_FAILURE;
+	}
+	if (cnt > MAX_CALLS)
+		cnt = MAX_CALLS;
+
+	used = 0;
+	for (j = 0; j < cnt; j++) {
+		struct syscall_stat* st = &after[j];
+		int k;
+
+		st->calls -= before[j].calls;
+		st->errors -= before[j].errors;
+		st->ns -= before[j].ns;
+		for (k = 0; k < SYSCALL_HIST_CNT; k++) st->hist[k] -= before[j].hist[k];
+		if (st->calls == 0)
+			continue;
+		sorted[used++] = st;
+		total_ns += st->ns;
+		total_calls += st->calls;
+		total_errors += st->errors;
+	}
+	qsort(sorted, used, sizeof *sorted, compare_time);
+
+	printf("%% time     total us   us/call     calls    errors syscall\n");
+	printf("------ ------------ --------- --------- --------- ----------------\n");
+	for (j = 0; j < used; j++) {
+		const struct syscall_stat* st = sorted[j];
+
+		printf(
+			 "%6d %12" PRIu64 " %9" PRIu64 " %9u %9u %s\n",
+			 total_ns > 0 ? (int) (st->ns * 100 / total_ns) : 0,
+			 st->ns / 1000,
+			 st->ns / 1000 / st->calls,
+			 st->calls,
+			 st->errors,
+			 st->name);
+	}
+	printf("------ ------------ --------- --------- --------- ----------------\n");
+	printf("%6d %12" PRIu64 " %9s %9u %9u total\n", 100, total_ns / 1000, "", total_calls, total_errors);
+
+	if (histograms) {
+		printf("\n");
+		for (j = 0; j < used; j++) print_histogram(sorted[j]);
+	}
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,330 @@
+#include "rbtree.h"
+
+#include "../debug.h"
+
+/* A red-black tree is a binary search tree whose nodes are each
+	colored red or black, subject to two rules:
+
+	  - A red node has no red children.
+
+	  - Every path from a node down to a missing child passes
+		 through the same number of black nodes.
+
+	Together these keep the longest path from the root no more
+	than twice as long as the shortest, so the height is O(lg n).
+	Insertion and removal first modify the tree as in any binary
+	search tree and then restore the rules with recoloring and
+	O(1) rotations on the path back up to the root.  Missing
+	children are represented as null pointers and count as black.
+
+	The algorithms follow [CLRS] chapter 13. */
+
+static void rotate_left(struct rb_tree*, struct rb_elem*);
+static void rotate_right(struct rb_tree*, struct rb_elem*);
+static void transplant(struct rb_tree*, struct rb_elem* u, struct rb_elem* v);
+static void insert_fixup(struct rb_tree*, struct rb_elem*);
+static void remove_fixup(struct rb_tree*, struct rb_elem* x, struct rb_elem* parent);
+
+/* Returns true if E is red.  Null children are black. */
+static inline bool is_red(const struct rb_elem* e)
+{
+	return e != NULL && e->red;
+}
+
+/* Returns the leftmost element of the subtree rooted at E. */
+static inline struct rb_elem* leftmost(struct rb_elem* e)
+{
+	while (e->left != NULL) e = e->left;
+	return e;
+}
+
+/* Initializes TREE as an empty tree ordered by LESS given
+	auxiliary data AUX. */
+void rb_init(struct rb_tree* tree, rb_less_func* less, void* aux)
+{
+	ASSERT(tree != NULL);
+	ASSERT(less != NULL);
+
+	tree->root = NULL;
+	tree->min = NULL;
+	tree->size = 0;
+	tree->less = less;
+	tree->aux = aux;
+}
+
+/* Inserts ELEM into TREE, after any elements equal to it. */
+void rb_insert(struct rb_tree* tree, struct rb_elem* elem)
+{
+	struct rb_elem** link = &tree->root;
+	struct rb_elem* parent = NULL;
+	bool is_min = true;
+
+	ASSERT(tree != NULL);
+	ASSERT(elem != NULL);
+
+	while (*link != NULL) {
+		parent = *link;
+		if (tree->less(elem, parent, tree->aux))
+			link = &parent->left;
+		else {
+			link = &parent->right;
+			is_min = false;
+		}
+	}
+
+	elem->parent = parent;
+	elem->left = elem->right = NULL;
+	elem->red = true;
+	*link = elem;
+	if (is_min)
+		tree->min = elem;
+	tree->size++;
+
+	insert_fixup(tree, elem);
+}
+
+/* Removes ELEM, which must be in TREE, from TREE. */
+void rb_remove(struct rb_tree* tree, struct rb_elem* elem)
+{
+	struct rb_elem* y = elem; /* Node actually unlinked. */
+	struct rb_elem* x;		  /* Node that takes Y's place. */
+	struct rb_elem* x_parent; /* X's parent, since X may be null. */
+	bool y_was_red = y->red;
+
+	ASSERT(tree != NULL);
+	ASSERT(elem != NULL);
+	ASSERT(tree->size > 0);
+
+	if (tree->min == elem)
+		tree->min = rb_next(elem);
+
+	if (elem->left == NULL) {
+		x = elem->right;
+		x_parent = elem->parent;
+		transplant(tree, elem, elem->right);
+	}
+	else if (elem->right == NULL) {
+		x = elem->left;
+		x_parent = elem->parent;
+		transplant(tree, elem, elem->left);
+	}
+	else {
+		/* Replace ELEM by its successor Y, which has no left
+			child. */
+		y = leftmost(elem->right);
+		y_was_red = y->red;
+		x = y->right;
+		if (y->parent == elem)
+			x_parent = y;
+		else {
+			x_parent = y->parent;
+			transplant(tree, y, y->right);
+			y->right = elem->right;
+			y->right->parent = y;
+		}
+		transplant(tree, elem, y);
+		y->left = elem->left;
+		y->left->parent = y;
+		y->red = elem->red;
+	}
+	tree->size--;
+
+	/* Removing a black node shortens the paths through X. */
+	if (!y_was_red)
+		remove_fixup(tree, x, x_parent);
+}
+
+/* Returns the smallest element in TREE, or a null pointer if
+	TREE is empty. */
+struct rb_elem* rb_min(const struct rb_tree* tree)
+{
+	ASSERT(tree != NULL);
+
+	return tree->min;
+}
+
+/* Returns the element following ELEM in its tree, or a null
+	pointer if ELEM is the largest. */
+struct rb_elem* rb_next(const struct rb_elem* elem)
+{
+	ASSERT(elem != NULL);
+
+	if (elem->right != NULL)
+		return leftmost(elem->right);
+	while (elem->parent != NULL && elem == elem->parent->right) elem = elem->parent;
+	return elem->parent;
+}
+
+/* Returns the number of elements in TREE. */
+size_t rb_size(const struct rb_tree* tree)
+{
+	ASSERT(tree != NULL);
+
+	return tree->size;
+}
+
+/* Returns true if TREE is empty, false otherwise. */
+bool rb_empty(const struct rb_tree* tree)
+{
+	ASSERT(tree != NULL);
+
+	return tree->root == NULL;
+}
+
+/* Rotates the subtree rooted at X to the left, making X's right
+	child its parent. */
+static void rotate_left(struct rb_tree* tree, struct rb_elem* x)
+{
+	struct rb_elem* y = x->right;
+
+	x->right = y->left;
+	if (y->left != NULL)
+		y->left->parent = x;
+	transplant(tree, x, y);
+	y->left = x;
+	x->parent = y;
+}
+
+/* Rotates the subtree rooted at X to the right, making X's left
+	child its parent. */
+static void rotate_right(struct rb_tree* tree, struct rb_elem* x)
+{
+	struct rb_elem* y = x->left;
+
+	x->left = y->right;
+	if (y->right != NULL)
+		y->right->parent = x;
+	transplant(tree, x, y);
+	y->right = x;
+	x->parent = y;
+}
+
+/* Puts V, which may be null, where U is in TREE's structure,
+	linking it to U's parent.  Does not change U's or V's
+	children. */
+static void transplant(struct rb_tree* tree, struct rb_elem* u, struct rb_elem* v)
+{
+	if (u->parent == NULL)
+		tree->root = v;
+	else if (u == u->parent->left)
+		u->parent->left = v;
+	else
+		u->parent->right = v;
+	if (v != NULL)
+		v->parent = u->parent;
+}
+
+/* Restores the red-black rules after inserting red node Z. */
+static void insert_fixup(struct rb_tree* tree, struct rb_elem* z)
+{
+	while (is_red(z->parent)) {
+		struct rb_elem* parent = z->parent;
+		struct rb_elem* grandparent = parent->parent; /* A red node is not the root. */
+
+		if (parent == grandparent->left) {
+			struct rb_elem* uncle = grandparent->right;
+			if (is_red(uncle)) {
+				parent->red = uncle->red = false;
+				grandparent->red = true;
+				z = grandparent;
+			}
+			else {
+				if (z == parent->right) {
+					z = parent;
+					rotate_left(tree, z);
+					parent = z->parent;
+				}
+				parent->red = false;
+				grandparent->red = true;
+				rotate_right(tree, grandparent);
+			}
+		}
+		else {
+			struct rb_elem* uncle = grandparent->left;
+			if (is_red(uncle)) {
+				parent->red = uncle->red = false;
+				grandparent->red = true;
+				z = grandparent;
+			}
+			else {
+				if (z == parent->left) {
+					z = parent;
+					rotate_right(tree, z);
+					parent = z->parent;
+				}
+				parent->red = false;
+				grandparent->red = true;
+				rotate_left(tree, grandparent);
+			}
+		}
+	}
+	tree->root->red = false;
+}
+
+/* Restores the red-black rules after removing a black node,
+	whose place X, a child of PARENT, has taken.  X may be null. */
+static void remove_fixup(struct rb_tree* tree, struct rb_elem* x, struct rb_elem* parent)
+{
+	/* X carries an extra black.  Move it up until it reaches a red
+		node, which can absorb it, or the root. */
+	while (x != tree->root && !is_red(x)) {
+		/* X's sibling is not null, because paths through it must
+			have at least one more black node than paths through X. */
+		if (x == parent->left) {
+			struct rb_elem* sibling = parent->right;
+			if (sibling->red) {
+				sibling->red = false;
+				parent->red = true;
+				rotate_left(tree, parent);
+				sibling = parent->right;
+			}
+			if (!is_red(sibling->left) && !is_red(sibling->right)) {
+				sibling->red = true;
+				x = parent;
+				parent = x->parent;
+			}
+			else {
+				if (!is_red(sibling->right)) {
+					sibling->left->red = false;
+					sibling->red = true;
+					rotate_right(tree, sibling);
+					sibling = parent->right;
+				}
+				sibling->red = parent->red;
+				parent->red = false;
+				sibling->right->red = false;
+				rotate_left(tree, parent);
+				x = tree->root;
+			}
+		}
+		else {
+			struct rb_elem* sibling = parent->left;
+			if (sibling->red) {
+				sibling->red = false;
+				parent->red = true;
+				rotate_right(tree, parent);
+				sibling = parent->left;
+			}
+			if (!is_red(sibling->left) && !is_red(sibling->right)) {
+				sibling->red = true;
+				x = parent;
+				parent = x->parent;
+			}
+			else {
+				if (!is_red(sibling->left)) {
+					sibling->right->red = false;
+					sibling->red = true;
+					rotate_left(tree, sibling);
+					sibling = parent->left;
+				}
+				sibling->red = parent->red;
+				parent->red = false;
+				sibling->left->red = false;
+				rotate_right(tree, parent);
+				x = tree->root;
+			}
+		}
+	}
+	if (x != NULL)
+		x->red = false;
+}
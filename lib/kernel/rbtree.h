@@ -0,0 +1,90 @@
+#ifndef __LIB_KERNEL_RBTREE_H
+#define __LIB_KERNEL_RBTREE_H
+
+/* Red-black tree.
+
+	A balanced binary search tree that keeps its elements ordered
+	by a caller-supplied comparison function.  Insertion and
+	removal take O(lg n) time, and the minimum element is cached,
+	so finding it takes O(1) time.
+
+	Like struct list, this tree does not allocate memory.  Each
+	structure that can be in a tree embeds a struct rb_elem, and
+	rb_entry() converts from the struct rb_elem back to the
+	enclosing structure.  For example:
+
+		struct foo
+		  {
+			 struct rb_elem elem;
+			 int key;
+			 ...other members...
+		  };
+
+		static bool
+		foo_less (const struct rb_elem *a, const struct rb_elem *b,
+					 void *aux UNUSED)
+		{
+		  return (rb_entry (a, struct foo, elem)->key
+					 < rb_entry (b, struct foo, elem)->key);
+		}
+
+		struct rb_tree foo_tree;
+
+		rb_init (&foo_tree, foo_less, NULL);
+
+	Elements that compare equal are kept in insertion order, so a
+	tree can serve as a priority queue that is FIFO among equals.
+
+	A tree may be modified only through these functions.  Changing
+	the key of an element while it is in a tree corrupts the
+	tree: remove the element, change its key, and insert it
+	again. */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* Tree element. */
+struct rb_elem {
+	struct rb_elem* parent; /* Parent, or null for the root. */
+	struct rb_elem* left;	/* Left child, or null. */
+	struct rb_elem* right;	/* Right child, or null. */
+	bool red;					/* Red, as opposed to black? */
+};
+
+/* Compares the value of two tree elements A and B, given
+	auxiliary data AUX.  Returns true if A is less than B, or
+	false if A is greater than or equal to B. */
+typedef bool rb_less_func(const struct rb_elem* a, const struct rb_elem* b, void* aux);
+
+/* Tree. */
+struct rb_tree {
+	struct rb_elem* root; /* Root, or null if empty. */
+	struct rb_elem* min;	 /* Leftmost element, or null if empty. */
+	size_t size;			 /* Number of elements. */
+	rb_less_func* less;	 /* Comparison function. */
+	void* aux;				 /* Auxiliary data for `less'. */
+};
+
+/* Converts pointer to tree element RB_ELEM into a pointer to
+	the structure that RB_ELEM is embedded inside.  Supply the
+	name of the outer structure STRUCT and the member name MEMBER
+	of the tree element. */
+#define rb_entry(RB_ELEM, STRUCT, MEMBER) \
+	((STRUCT*) ((uint8_t*) &(RB_ELEM)->parent - offsetof(STRUCT, MEMBER.parent)))
+
+void rb_init(struct rb_tree*, rb_less_func*, void* aux);
+
+/* Modification. */
+void rb_insert(struct rb_tree*, struct rb_elem*);
+void rb_remove(struct rb_tree*, struct rb_elem*);
+
+/* Traversal, in ascending order. */
+struct rb_elem* rb_min(const struct rb_tree*);
+struct rb_elem* rb_next(const struct rb_elem*);
+
+/* Properties. */
+size_t rb_size(const struct rb_tree*);
+bool rb_empty(const struct rb_tree*);
+
+#endif /* lib/kernel/rbtree.h */
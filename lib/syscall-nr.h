@@ -28,7 +28,18 @@ enum {
 	SYS_MKDIR,	 /* Create a directory. */
 	SYS_READDIR, /* Reads a directory entry. */
 	SYS_ISDIR,	 /* Tests if a fd represents a directory. */
-	SYS_INUMBER	 /* Returns the inode number for a fd. */
+	SYS_INUMBER, /* Returns the inode number for a fd. */
+
+	/* Extensions. */
+	SYS_NANOSLEEP,		 /* Sleeps with sub-tick resolution. */
+	SYS_CLOCK_GETTIME, /* Reads the time since boot. */
+	SYS_FUTEX_WAIT,	 /* Waits for a change to a user int. */
+	SYS_FUTEX_WAKE,	 /* Wakes threads waiting on a user int. */
+	SYS_STATS,			 /* Reads system call statistics. */
+	SYS_READV,			 /* Reads a file into several buffers. */
+	SYS_WRITEV,			 /* Writes several buffers to a file. */
+	SYS_PREAD,			 /* Reads a file at a given offset. */
+	SYS_PWRITE			 /* Writes a file at a given offset. */
 };
 
 #endif /* lib/syscall-nr.h */
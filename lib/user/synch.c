@@ -0,0 +1,145 @@
+#include <debug.h>
+#include <stddef.h>
+#include <synch.h>
+#include <syscall.h>
+
+/* The mutex follows "mutex2" of Ulrich Drepper's "Futexes Are
+	Tricky": unlocking calls futex_wake() only if the state says
+	that some thread may be waiting. */
+
+/* Initializes MUTEX as unlocked. */
+void mutex_init(struct mutex* mutex)
+{
+	mutex->state = 0;
+}
+
+/* Acquires MUTEX, sleeping until it is available if necessary. */
+void mutex_lock(struct mutex* mutex)
+{
+	int c = 0;
+
+	/* Fast path: unlocked to locked. */
+	if (__atomic_compare_exchange_n(&mutex->state, &c, 1, false, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+		return;
+
+	/* Mark the mutex as having waiters, then sleep until we find
+		it unlocked.  We cannot know whether others still wait, so
+		we take it in state 2, at the cost of one spurious wakeup
+		when it is released. */
+	if (c != 2)
+		c = __atomic_exchange_n(&mutex->state, 2, __ATOMIC_ACQUIRE);
+	while (c != 0) {
+		futex_wait(&mutex->state, 2, NULL);
+		c = __atomic_exchange_n(&mutex->state, 2, __ATOMIC_ACQUIRE);
+	}
+}
+
+/* Acquires MUTEX if it is unlocked, without sleeping.  Returns
+	true if successful. */
+bool mutex_try_lock(struct mutex* mutex)
+{
+	int c = 0;
+
+	return __atomic_compare_exchange_n(&mutex->state, &c, 1, false, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED);
+}
+
+/* Releases MUTEX, which must be locked, waking one waiter if
+	there may be any. */
+void mutex_unlock(struct mutex* mutex)
+{
+	if (__atomic_fetch_sub(&mutex->state, 1, __ATOMIC_RELEASE) != 1) {
+		__atomic_store_n(&mutex->state, 0, __ATOMIC_RELEASE);
+		futex_wake(&mutex->state, 1);
+	}
+}
+
+/* Initializes COND. */
+void cond_init(struct cond* cond)
+{
+	cond->seq = 0;
+	cond->waiters = 0;
+}
+
+/* Atomically releases MUTEX, which must be locked, and waits for
+	COND to be signaled, then reacquires MUTEX.  As with any
+	condition variable, the wait may end without a signal, so the
+	caller should recheck its condition in a loop. */
+void cond_wait(struct cond* cond, struct mutex* mutex)
+{
+	int seq = __atomic_load_n(&cond->seq, __ATOMIC_RELAXED);
+
+	/* A signal sent after we read SEQ changes it, so futex_wait()
+		returns at once instead of missing the signal. */
+	cond->waiters++;
+	mutex_unlock(mutex);
+	futex_wait(&cond->seq, seq, NULL);
+	mutex_lock(mutex);
+	cond->waiters--;
+}
+
+/* Wakes one thread waiting on COND, if any.  MUTEX must be
+	locked.  Makes no system call if no thread waits. */
+void cond_signal(struct cond* cond, struct mutex* mutex)
+{
+	ASSERT(mutex->state != 0);
+
+	if (cond->waiters > 0) {
+		__atomic_fetch_add(&cond->seq, 1, __ATOMIC_RELAXED);
+		futex_wake(&cond->seq, 1);
+	}
+}
+
+/* Wakes all threads waiting on COND.  MUTEX must be locked. */
+void cond_broadcast(struct cond* cond, struct mutex* mutex)
+{
+	ASSERT(mutex->state != 0);
+
+	if (cond->waiters > 0) {
+		__atomic_fetch_add(&cond->seq, 1, __ATOMIC_RELAXED);
+		futex_wake(&cond->seq, cond->waiters);
+	}
+}
+
+/* Initializes SEM to VALUE. */
+void sem_init(struct sem* sem, int value)
+{
+	ASSERT(value >= 0);
+
+	sem->value = value;
+	sem->waiters = 0;
+}
+
+/* Waits for SEM's value to become positive and then decrements
+	it. */
+void sem_down(struct sem* sem)
+{
+	while (!sem_try_down(sem)) {
+		/* sem_up() increments the value before it checks for
+			waiters, and we count ourselves before futex_wait()
+			checks the value, so one of us sees the other. */
+		__atomic_fetch_add(&sem->waiters, 1, __ATOMIC_SEQ_CST);
+		futex_wait(&sem->value, 0, NULL);
+		__atomic_fetch_sub(&sem->waiters, 1, __ATOMIC_SEQ_CST);
+	}
+}
+
+/* Decrements SEM's value if it is positive, without sleeping.
+	Returns true if successful. */
+bool sem_try_down(struct sem* sem)
+{
+	int value = __atomic_load_n(&sem->value, __ATOMIC_RELAXED);
+
+	while (value > 0)
+		if (__atomic_compare_exchange_n(&sem->value, &value, value - 1, false, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+			return true;
+	return false;
+}
+
+/* Increments SEM's value and wakes one waiter, if any.  Makes no
+	system call if no thread waits. */
+void sem_up(struct sem* sem)
+{
+	__atomic_fetch_add(&sem->value, 1, __ATOMIC_SEQ_CST);
+	if (__atomic_load_n(&sem->waiters, __ATOMIC_SEQ_CST) > 0)
+		futex_wake(&sem->value, 1);
+}
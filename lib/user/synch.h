@@ -0,0 +1,43 @@
+#ifndef __LIB_USER_SYNCH_H
+#define __LIB_USER_SYNCH_H
+
+#include <stdbool.h>
+
+/* Synchronization for user programs, built on futex_wait() and
+	futex_wake().  Each operation is a few atomic instructions
+	when there is no contention and enters the kernel only to
+	sleep or to wake a sleeper. */
+
+/* A mutual exclusion lock. */
+struct mutex {
+	int state; /* 0: unlocked, 1: locked, 2: locked with waiters. */
+};
+
+void mutex_init(struct mutex*);
+void mutex_lock(struct mutex*);
+bool mutex_try_lock(struct mutex*);
+void mutex_unlock(struct mutex*);
+
+/* A condition variable, used with a mutex. */
+struct cond {
+	int seq;		 /* Incremented by each signal. */
+	int waiters; /* Waiting threads, protected by the mutex. */
+};
+
+void cond_init(struct cond*);
+void cond_wait(struct cond*, struct mutex*);
+void cond_signal(struct cond*, struct mutex*);
+void cond_broadcast(struct cond*, struct mutex*);
+
+/* A counting semaphore. */
+struct sem {
+	int value;	 /* Current value. */
+	int waiters; /* Threads sleeping in sem_down(). */
+};
+
+void sem_init(struct sem*, int value);
+void sem_down(struct sem*);
+bool sem_try_down(struct sem*);
+void sem_up(struct sem*);
+
+#endif /* lib/user/synch.h */
@@ -54,6 +54,21 @@
 		retval;                                                                          \
 	})
 
+/* Invokes syscall NUMBER, passing arguments ARG0, ARG1, ARG2,
+	and ARG3, and returns the return value as an `int'. */
+#define syscall4(NUMBER, ARG0, ARG1, ARG2, ARG3)                                        \
+	({                                                                                   \
+		int retval;                                                                       \
+		asm volatile(                                                                     \
+			 "pushl %[arg3]; pushl %[arg2]; pushl %[arg1]; pushl %[arg0]; "                \
+			 "pushl %[number]; int $0x30; addl $20, %%esp"                                 \
+			 : "=a"(retval)                                                                \
+			 : [number] "i"(NUMBER), [arg0] "r"(ARG0), [arg1] "r"(ARG1), [arg2] "r"(ARG2), \
+				[arg3] "r"(ARG3)                                                            \
+			 : "memory");                                                                  \
+		retval;                                                                           \
+	})
+
 
 void sleep(int millis){
 	syscall1(SYS_SLEEP, millis);
@@ -163,3 +178,48 @@ int inumber(int fd)
 {
 	return syscall1(SYS_INUMBER, fd);
 }
+
+int nanosleep(const struct timespec* req)
+{
+	return syscall1(SYS_NANOSLEEP, req);
+}
+
+int clock_gettime(struct timespec* tp)
+{
+	return syscall1(SYS_CLOCK_GETTIME, tp);
+}
+
+int futex_wait(int* addr, int expected, const struct timespec* timeout)
+{
+	return syscall3(SYS_FUTEX_WAIT, addr, expected, timeout);
+}
+
+int futex_wake(int* addr, int n)
+{
+	return syscall2(SYS_FUTEX_WAKE, addr, n);
+}
+
+int syscall_stats(int scope, struct syscall_stat* stats, int cnt)
+{
+	return syscall3(SYS_STATS, scope, stats, cnt);
+}
+
+int readv(int fd, const struct iovec* iov, int iovcnt)
+{
+	return syscall3(SYS_READV, fd, iov, iovcnt);
+}
+
+int writev(int fd, const struct iovec* iov, int iovcnt)
+{
+	return syscall3(SYS_WRITEV, fd, iov, iovcnt);
+}
+
+int pread(int fd, void* buffer, unsigned length, unsigned offset)
+{
+	return syscall4(SYS_PREAD, fd, buffer, length, offset);
+}
+
+int pwrite(int fd, const void* buffer, unsigned length, unsigned offset)
+{
+	return syscall4(SYS_PWRITE, fd, buffer, length, offset);
+}
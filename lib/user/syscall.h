@@ -3,6 +3,8 @@
 
 #include <debug.h>
 #include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
 
 /* Process identifier. */
 typedef int pid_t;
@@ -15,6 +17,44 @@ typedef int mapid_t;
 /* Maximum characters in a filename written by readdir(). */
 #define READDIR_MAX_LEN 14
 
+/* Interval for nanosleep() and futex_wait(), or time since boot
+	for clock_gettime(). */
+struct timespec {
+	long tv_sec;  /* Seconds. */
+	long tv_nsec; /* Nanoseconds, 0...999,999,999. */
+};
+
+/* A buffer for readv() and writev(). */
+struct iovec {
+	void* iov_base; /* Start of buffer. */
+	size_t iov_len; /* Size of buffer in bytes. */
+};
+
+/* Results of futex_wait(). */
+#define FUTEX_WOKEN 0		 /* Woken by futex_wake(). */
+#define FUTEX_AGAIN (-1)	 /* *ADDR did not hold EXPECTED. */
+#define FUTEX_TIMEDOUT (-2) /* Timeout passed. */
+#define FUTEX_INVALID (-3)	 /* Timeout out of range. */
+
+/* Buckets in a system call latency histogram.  Bucket 0 counts
+	calls that took less than 1 us, bucket I calls that took from
+	2**(I-1) us up to 2**I us, and the last bucket also every
+	longer call. */
+#define SYSCALL_HIST_CNT 16
+
+/* Statistics for one system call number, from syscall_stats(). */
+struct syscall_stat {
+	char name[16];							 /* Name, or "" if unused number. */
+	unsigned calls;						 /* Times called. */
+	unsigned errors;						 /* Times failed. */
+	uint64_t ns;							 /* Total time in the call. */
+	unsigned hist[SYSCALL_HIST_CNT]; /* Latency histogram. */
+};
+
+/* Scopes for syscall_stats(). */
+#define STATS_PROCESS 0 /* The calling process. */
+#define STATS_SYSTEM 1	 /* All processes since boot. */
+
 /* Typical return values from main() and arguments to exit(). */
 #define EXIT_SUCCESS 0 /* Successful execution. */
 #define EXIT_FAILURE 1 /* Unsuccessful execution. */
@@ -46,4 +86,15 @@ bool readdir(int fd, char name[READDIR_MAX_LEN + 1]);
 bool isdir(int fd);
 int inumber(int fd);
 
+/* Extensions. */
+int nanosleep(const struct timespec* req);
+int clock_gettime(struct timespec* tp);
+int futex_wait(int* addr, int expected, const struct timespec* timeout);
+int futex_wake(int* addr, int n);
+int syscall_stats(int scope, struct syscall_stat* stats, int cnt);
+int readv(int fd, const struct iovec* iov, int iovcnt);
+int writev(int fd, const struct iovec* iov, int iovcnt);
+int pread(int fd, void* buffer, unsigned length, unsigned offset);
+int pwrite(int fd, const void* buffer, unsigned length, unsigned offset);
+
 #endif /* lib/user/syscall.h */
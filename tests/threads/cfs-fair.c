@@ -0,0 +1,92 @@
+/* Checks that the completely fair scheduler divides the CPU in
+	proportion to the weights of the threads' nice values.
+
+	The cfs-fair-2 test runs 2 threads at nice 0, which should
+	receive about the same number of ticks.  The cfs-nice-2 test
+	runs one thread at nice 0 and one at nice 5, whose weights are
+	1024 and 335, so they should receive about 754 and 246 of the
+	1,000 ticks for which they run. */
+
+#include "devices/timer.h"
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/thread.h"
+
+#include <inttypes.h>
+#include <stdio.h>
+
+static void test_cfs_fair(int thread_cnt, int nice_min, int nice_step);
+
+void test_cfs_fair_2(void)
+{
+	test_cfs_fair(2, 0, 0);
+}
+
+void test_cfs_nice_2(void)
+{
+	test_cfs_fair(2, 0, 5);
+}
+
+#define MAX_THREAD_CNT 20
+
+struct thread_info {
+	int64_t start_time;
+	int tick_count;
+	int nice;
+};
+
+static void load_thread(void* aux);
+
+static void test_cfs_fair(int thread_cnt, int nice_min, int nice_step)
+{
+	struct thread_info info[MAX_THREAD_CNT];
+	int64_t start_time;
+	int nice;
+	int i;
+
+	ASSERT(thread_cfs);
+	ASSERT(thread_cnt <= MAX_THREAD_CNT);
+
+	start_time = timer_ticks();
+	msg("Starting %d threads...", thread_cnt);
+	nice = nice_min;
+	for (i = 0; i < thread_cnt; i++) {
+		struct thread_info* ti = &info[i];
+		char name[16];
+
+		ti->start_time = start_time;
+		ti->tick_count = 0;
+		ti->nice = nice;
+
+		snprintf(name, sizeof name, "load %d", i);
+		thread_create(name, PRI_DEFAULT, load_thread, ti);
+
+		nice += nice_step;
+	}
+
+	msg("Sleeping 12 seconds to let threads run, please wait...");
+	timer_sleep(12 * TIMER_FREQ);
+
+	for (i = 0; i < thread_cnt; i++)
+		msg("Thread %d received %d ticks.", i, info[i].tick_count);
+}
+
+/* Sets its nice value, waits until every thread has started,
+	and then counts the ticks during which it runs for 10
+	seconds. */
+static void load_thread(void* ti_)
+{
+	struct thread_info* ti = ti_;
+	int64_t sleep_time = 1 * TIMER_FREQ;
+	int64_t spin_time = sleep_time + 10 * TIMER_FREQ;
+	int64_t last_time = 0;
+
+	thread_set_nice(ti->nice);
+	timer_sleep(sleep_time - timer_elapsed(ti->start_time));
+	while (timer_elapsed(ti->start_time) < spin_time) {
+		int64_t cur_time = timer_ticks();
+		if (cur_time != last_time)
+			ti->tick_count++;
+		last_time = cur_time;
+	}
+}
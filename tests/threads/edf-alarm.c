@@ -0,0 +1,108 @@
+/* Checks that a thread in the earliest-deadline-first class
+	wakes up on time from its alarms even while threads of the
+	highest priority keep the CPU busy, and that reservations
+	that would overcommit the CPU are refused. */
+
+#include "devices/timer.h"
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+
+#include <stdio.h>
+
+#define PERIOD 5	  /* Period of the EDF thread, in ticks. */
+#define BUDGET 1	  /* Its budget, in ticks. */
+#define JOB_CNT 20  /* Number of periods it runs for. */
+#define LOAD_CNT 3  /* Number of busy threads. */
+
+static thread_func edf_thread;
+static thread_func load_thread;
+static bool reserve(int64_t period, int64_t budget);
+
+static struct semaphore edf_ready; /* Upped after the first attempt. */
+static struct semaphore edf_go;	  /* Upped to make the second. */
+static struct semaphore done_sema; /* Upped by each thread as it exits. */
+static volatile bool done;			  /* Tells the busy threads to stop. */
+
+void test_edf_alarm(void)
+{
+	int i;
+
+	/* This test does not work with the MLFQS. */
+	ASSERT(!thread_mlfqs);
+
+	sema_init(&edf_ready, 0);
+	sema_init(&edf_go, 0);
+	sema_init(&done_sema, 0);
+
+	/* The whole CPU may not be reserved, but most of it may. */
+	reserve(10, 10);
+	reserve(10, 8);
+
+	/* While we hold our reservation, there is no room for
+		another one of 20%. */
+	thread_create("edf", PRI_MAX, edf_thread, NULL);
+	sema_down(&edf_ready);
+
+	/* Release ours to make room.  The EDF thread then preempts
+		us. */
+	sema_up(&edf_go);
+	msg("Releasing reservation.");
+	reserve(0, 0);
+
+	for (i = 0; i < LOAD_CNT + 1; i++) sema_down(&done_sema);
+}
+
+/* Reserves BUDGET of every PERIOD ticks for the running thread
+	and reports whether the reservation was admitted. */
+static bool reserve(int64_t period, int64_t budget)
+{
+	bool ok = thread_set_deadline(period, budget);
+	if (period != 0)
+		msg("Reserving %d of every %d ticks: %s.", (int) budget, (int) period, ok ? "admitted" : "refused");
+	return ok;
+}
+
+/* Runs one short job in each of JOB_CNT periods, sleeping from
+	one period to the next, while LOAD_CNT threads of the highest
+	priority spin. */
+static void edf_thread(void* aux UNUSED)
+{
+	int64_t start;
+	int late = 0;
+	int i;
+
+	reserve(PERIOD, BUDGET);
+	sema_up(&edf_ready);
+	sema_down(&edf_go);
+	if (!reserve(PERIOD, BUDGET))
+		fail("reservation refused");
+
+	/* We stay ahead of the busy threads, whose priority is as
+		high as ours, even as we create them. */
+	start = timer_ticks();
+	for (i = 0; i < LOAD_CNT; i++) {
+		char name[16];
+		snprintf(name, sizeof name, "load %d", i);
+		thread_create(name, PRI_MAX, load_thread, NULL);
+	}
+
+	for (i = 1; i <= JOB_CNT; i++) {
+		int64_t wake = start + i * PERIOD;
+		timer_sleep(wake - timer_ticks());
+		if (timer_ticks() != wake)
+			late++;
+	}
+	done = true;
+
+	msg("%d of %d alarms late, %u deadlines missed.", late, JOB_CNT, thread_get_deadline_misses());
+	sema_up(&done_sema);
+}
+
+/* Spins until the EDF thread is done. */
+static void load_thread(void* aux UNUSED)
+{
+	while (!done) continue;
+	sema_up(&done_sema);
+}
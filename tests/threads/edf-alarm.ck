@@ -0,0 +1,15 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(edf-alarm) begin
+(edf-alarm) Reserving 10 of every 10 ticks: refused.
+(edf-alarm) Reserving 8 of every 10 ticks: admitted.
+(edf-alarm) Reserving 1 of every 5 ticks: refused.
+(edf-alarm) Releasing reservation.
+(edf-alarm) Reserving 1 of every 5 ticks: admitted.
+(edf-alarm) 0 of 20 alarms late, 0 deadlines missed.
+(edf-alarm) end
+EOF
+pass;
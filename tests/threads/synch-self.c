@@ -0,0 +1,21 @@
+/* Runs the self-tests of the synchronization primitives in
+	threads/synch.c: semaphores, readers-writer locks, and waits
+	with timeouts.  Each self-test panics the kernel if it
+	fails. */
+
+#include "tests/threads/tests.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+
+#include <debug.h>
+
+void test_synch_self(void)
+{
+	/* This test does not work with the MLFQS. */
+	ASSERT(!thread_mlfqs);
+
+	sema_self_test();
+	rwlock_self_test();
+	synch_timeout_self_test();
+	pass();
+}
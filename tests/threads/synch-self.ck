@@ -0,0 +1,13 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(synch-self) begin
+Testing semaphores...done.
+Testing rwlocks...done.
+Testing timeouts...done.
+(synch-self) PASS
+(synch-self) end
+EOF
+pass;
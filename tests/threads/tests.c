@@ -13,30 +13,35 @@ static const struct test tests[] = {
 	 {"alarm-single", test_alarm_single},
 	 {"alarm-multiple", test_alarm_multiple},
 	 {"alarm-simultaneous", test_alarm_simultaneous},
-	 //	 {"alarm-priority", test_alarm_priority},
+	 {"alarm-priority", test_alarm_priority},
 	 {"alarm-zero", test_alarm_zero},
 	 {"alarm-negative", test_alarm_negative},
-	 //	 {"priority-change", test_priority_change},
-	 //	 {"priority-donate-one", test_priority_donate_one},
-	 //	 {"priority-donate-multiple", test_priority_donate_multiple},
-	 //	 {"priority-donate-multiple2", test_priority_donate_multiple2},
-	 //	 {"priority-donate-nest", test_priority_donate_nest},
-	 //	 {"priority-donate-sema", test_priority_donate_sema},
-	 //	 {"priority-donate-lower", test_priority_donate_lower},
-	 //	 {"priority-donate-chain", test_priority_donate_chain},
-	 //	 {"priority-fifo", test_priority_fifo},
-	 //	 {"priority-preempt", test_priority_preempt},
-	 //	 {"priority-sema", test_priority_sema},
-	 //	 {"priority-condvar", test_priority_condvar},
-	 //	 {"mlfqs-load-1", test_mlfqs_load_1},
-	 //	 {"mlfqs-load-60", test_mlfqs_load_60},
-	 //	 {"mlfqs-load-avg", test_mlfqs_load_avg},
-	 //	 {"mlfqs-recent-1", test_mlfqs_recent_1},
-	 //	 {"mlfqs-fair-2", test_mlfqs_fair_2},
-	 //	 {"mlfqs-fair-20", test_mlfqs_fair_20},
-	 //	 {"mlfqs-nice-2", test_mlfqs_nice_2},
-	 //	 {"mlfqs-nice-10", test_mlfqs_nice_10},
-	 //	 {"mlfqs-block", test_mlfqs_block},
+	 {"priority-change", test_priority_change},
+	 {"priority-donate-one", test_priority_donate_one},
+	 {"priority-donate-multiple", test_priority_donate_multiple},
+	 {"priority-donate-multiple2", test_priority_donate_multiple2},
+	 {"priority-donate-nest", test_priority_donate_nest},
+	 {"priority-donate-sema", test_priority_donate_sema},
+	 {"priority-donate-lower", test_priority_donate_lower},
+	 {"priority-donate-chain", test_priority_donate_chain},
+	 {"priority-fifo", test_priority_fifo},
+	 {"priority-preempt", test_priority_preempt},
+	 {"priority-sema", test_priority_sema},
+	 {"priority-condvar", test_priority_condvar},
+	 {"synch-self", test_synch_self},
+	 {"workqueue", test_workqueue},
+	 {"mlfqs-load-1", test_mlfqs_load_1},
+	 {"mlfqs-load-60", test_mlfqs_load_60},
+	 {"mlfqs-load-avg", test_mlfqs_load_avg},
+	 {"mlfqs-recent-1", test_mlfqs_recent_1},
+	 {"mlfqs-fair-2", test_mlfqs_fair_2},
+	 {"mlfqs-fair-20", test_mlfqs_fair_20},
+	 {"mlfqs-nice-2", test_mlfqs_nice_2},
+	 {"mlfqs-nice-10", test_mlfqs_nice_10},
+	 {"mlfqs-block", test_mlfqs_block},
+	 {"cfs-fair-2", test_cfs_fair_2},
+	 {"cfs-nice-2", test_cfs_nice_2},
+	 {"edf-alarm", test_edf_alarm},
 };
 
 static const char* test_name;
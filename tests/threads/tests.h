@@ -8,30 +8,35 @@ typedef void test_func(void);
 extern test_func test_alarm_single;
 extern test_func test_alarm_multiple;
 extern test_func test_alarm_simultaneous;
-// extern test_func test_alarm_priority;
+extern test_func test_alarm_priority;
 extern test_func test_alarm_zero;
 extern test_func test_alarm_negative;
-// extern test_func test_priority_change;
-// extern test_func test_priority_donate_one;
-// extern test_func test_priority_donate_multiple;
-// extern test_func test_priority_donate_multiple2;
-// extern test_func test_priority_donate_sema;
-// extern test_func test_priority_donate_nest;
-// extern test_func test_priority_donate_lower;
-// extern test_func test_priority_donate_chain;
-// extern test_func test_priority_fifo;
-// extern test_func test_priority_preempt;
-// extern test_func test_priority_sema;
-// extern test_func test_priority_condvar;
-// extern test_func test_mlfqs_load_1;
-// extern test_func test_mlfqs_load_60;
-// extern test_func test_mlfqs_load_avg;
-// extern test_func test_mlfqs_recent_1;
-// extern test_func test_mlfqs_fair_2;
-// extern test_func test_mlfqs_fair_20;
-// extern test_func test_mlfqs_nice_2;
-// extern test_func test_mlfqs_nice_10;
-// extern test_func test_mlfqs_block;
+extern test_func test_priority_change;
+extern test_func test_priority_donate_one;
+extern test_func test_priority_donate_multiple;
+extern test_func test_priority_donate_multiple2;
+extern test_func test_priority_donate_sema;
+extern test_func test_priority_donate_nest;
+extern test_func test_priority_donate_lower;
+extern test_func test_priority_donate_chain;
+extern test_func test_priority_fifo;
+extern test_func test_priority_preempt;
+extern test_func test_priority_sema;
+extern test_func test_priority_condvar;
+extern test_func test_synch_self;
+extern test_func test_workqueue;
+extern test_func test_mlfqs_load_1;
+extern test_func test_mlfqs_load_60;
+extern test_func test_mlfqs_load_avg;
+extern test_func test_mlfqs_recent_1;
+extern test_func test_mlfqs_fair_2;
+extern test_func test_mlfqs_fair_20;
+extern test_func test_mlfqs_nice_2;
+extern test_func test_mlfqs_nice_10;
+extern test_func test_mlfqs_block;
+extern test_func test_cfs_fair_2;
+extern test_func test_cfs_nice_2;
+extern test_func test_edf_alarm;
 
 void msg(const char*, ...);
 void fail(const char*, ...);
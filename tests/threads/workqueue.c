@@ -0,0 +1,68 @@
+/* Tests the workqueue: every queued item runs once, items on a
+	higher-priority queue run before those on a lower-priority
+	one, a cancelled item does not run, and workqueue_flush()
+	waits for all of a queue's items to finish. */
+
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/thread.h"
+#include "threads/workqueue.h"
+
+#include <stdio.h>
+
+#define ITEM_CNT 4
+
+static work_func record_work;
+
+static struct workqueue low_wq, high_wq;
+static struct work items[ITEM_CNT * 2 + 1];
+static int order[ITEM_CNT * 2 + 1];
+static int order_cnt;
+
+void test_workqueue(void)
+{
+	struct work* cancelled = &items[ITEM_CNT * 2];
+	int i;
+
+	/* This test does not work with the MLFQS. */
+	ASSERT(!thread_mlfqs);
+
+	workqueue_setup(&low_wq, "test-low", PRI_DEFAULT + 1);
+	workqueue_setup(&high_wq, "test-high", PRI_DEFAULT + 2);
+
+	/* The workers wait at PRI_MAX, so at PRI_MAX ourselves we queue
+		everything before any of it runs. */
+	thread_set_priority(PRI_MAX);
+	for (i = 0; i < ITEM_CNT; i++) {
+		work_setup(&items[i], record_work, (void*) i);
+		work_queue(&low_wq, &items[i]);
+	}
+	work_setup(cancelled, record_work, (void*) (ITEM_CNT * 2));
+	work_queue(&low_wq, cancelled);
+	for (i = ITEM_CNT; i < ITEM_CNT * 2; i++) {
+		work_setup(&items[i], record_work, (void*) i);
+		work_queue(&high_wq, &items[i]);
+	}
+	if (work_queue(&high_wq, &items[ITEM_CNT]))
+		fail("item queued twice");
+	if (!work_cancel(cancelled))
+		fail("pending item could not be cancelled");
+
+	thread_set_priority(PRI_DEFAULT);
+	workqueue_flush(&low_wq);
+	workqueue_flush(&high_wq);
+
+	if (order_cnt != ITEM_CNT * 2)
+		fail("%d items ran, expected %d", order_cnt, ITEM_CNT * 2);
+	for (i = 0; i < order_cnt; i++)
+		if ((order[i] >= ITEM_CNT) != (i < ITEM_CNT))
+			fail("item %d ran in position %d", order[i], i);
+	if (work_pending(cancelled))
+		fail("cancelled item still pending");
+	msg("%d items ran in priority order.", order_cnt);
+}
+
+static void record_work(struct work* work UNUSED, void* i)
+{
+	order[order_cnt++] = (int) i;
+}
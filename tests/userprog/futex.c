@@ -0,0 +1,40 @@
+/* Tests futex_wait() and futex_wake() within a single process,
+	and the uncontended paths of the mutex, condition variable,
+	and semaphore in lib/user/synch.c. */
+
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#include <synch.h>
+#include <syscall.h>
+
+void test_main(void)
+{
+	struct timespec timeout = {0, 20 * 1000 * 1000};
+	struct timespec bad = {0, 1000 * 1000 * 1000};
+	int word = 1;
+	struct mutex mutex;
+	struct cond cond;
+	struct sem sem;
+
+	CHECK(futex_wait(&word, 0, NULL) == FUTEX_AGAIN, "wait with stale value");
+	CHECK(futex_wait(&word, 1, &timeout) == FUTEX_TIMEDOUT, "wait with timeout");
+	CHECK(futex_wait(&word, 1, &bad) == FUTEX_INVALID, "wait with invalid timeout");
+	CHECK(futex_wake(&word, 1) == 0, "wake with no waiters");
+
+	mutex_init(&mutex);
+	mutex_lock(&mutex);
+	CHECK(!mutex_try_lock(&mutex), "try to lock locked mutex");
+	cond_init(&cond);
+	cond_signal(&cond, &mutex);
+	cond_broadcast(&cond, &mutex);
+	mutex_unlock(&mutex);
+	CHECK(mutex_try_lock(&mutex), "try to lock unlocked mutex");
+	mutex_unlock(&mutex);
+
+	sem_init(&sem, 1);
+	sem_down(&sem);
+	CHECK(!sem_try_down(&sem), "try to down zero semaphore");
+	sem_up(&sem);
+	CHECK(sem_try_down(&sem), "try to down positive semaphore");
+}
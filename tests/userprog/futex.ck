@@ -0,0 +1,18 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(futex) begin
+(futex) wait with stale value
+(futex) wait with timeout
+(futex) wait with invalid timeout
+(futex) wake with no waiters
+(futex) try to lock locked mutex
+(futex) try to lock unlocked mutex
+(futex) try to down zero semaphore
+(futex) try to down positive semaphore
+(futex) end
+futex: exit(0)
+EOF
+pass;
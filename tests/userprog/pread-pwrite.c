@@ -0,0 +1,29 @@
+/* Writes and reads at explicit offsets with pwrite() and
+	pread(), and checks that neither moves the file position. */
+
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <syscall.h>
+
+void test_main(void)
+{
+	char buf[8];
+	int handle;
+
+	CHECK(create("pwrite.txt", 32), "create \"pwrite.txt\"");
+	CHECK((handle = open("pwrite.txt")) > 1, "open \"pwrite.txt\"");
+
+	CHECK(pwrite(handle, "hello", 5, 10) == 5, "pwrite 5 bytes at offset 10");
+	CHECK(tell(handle) == 0, "file position unchanged by pwrite");
+	CHECK(pread(handle, buf, 5, 10) == 5, "pread 5 bytes at offset 10");
+	CHECK(!memcmp(buf, "hello", 5), "pread returned written bytes");
+	CHECK(tell(handle) == 0, "file position unchanged by pread");
+	CHECK(pread(handle, buf, 5, 30) == 2, "pread past end of file is short");
+	CHECK(pread(STDOUT_FILENO, buf, 5, 0) == -1, "pread from console fails");
+
+	msg("close \"pwrite.txt\"");
+	close(handle);
+}
@@ -0,0 +1,20 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(pread-pwrite) begin
+(pread-pwrite) create "pwrite.txt"
+(pread-pwrite) open "pwrite.txt"
+(pread-pwrite) pwrite 5 bytes at offset 10
+(pread-pwrite) file position unchanged by pwrite
+(pread-pwrite) pread 5 bytes at offset 10
+(pread-pwrite) pread returned written bytes
+(pread-pwrite) file position unchanged by pread
+(pread-pwrite) pread past end of file is short
+(pread-pwrite) pread from console fails
+(pread-pwrite) close "pwrite.txt"
+(pread-pwrite) end
+pread-pwrite: exit(0)
+EOF
+pass;
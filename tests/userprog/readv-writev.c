@@ -0,0 +1,30 @@
+/* Gathers three buffers into a file with writev(), then
+	scatters the file into two buffers with readv(). */
+
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#include <string.h>
+#include <syscall.h>
+
+void test_main(void)
+{
+	char a[] = "abc", b[] = "defg", c[] = "hijkl";
+	struct iovec out[3] = {{a, 3}, {b, 4}, {c, 5}};
+	char first[5], second[7];
+	struct iovec in[2] = {{first, sizeof first}, {second, sizeof second}};
+	int handle;
+
+	CHECK(create("vector.txt", 12), "create \"vector.txt\"");
+	CHECK((handle = open("vector.txt")) > 1, "open \"vector.txt\"");
+
+	CHECK(writev(handle, out, 3) == 12, "writev 3 buffers");
+	CHECK(tell(handle) == 12, "file position advanced by writev");
+	seek(handle, 0);
+	CHECK(readv(handle, in, 2) == 12, "readv into 2 buffers");
+	CHECK(!memcmp(first, "abcde", 5) && !memcmp(second, "fghijkl", 7), "readv returned written bytes");
+	CHECK(readv(handle, in, -1) == -1, "readv with negative count fails");
+
+	msg("close \"vector.txt\"");
+	close(handle);
+}
@@ -0,0 +1,18 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(readv-writev) begin
+(readv-writev) create "vector.txt"
+(readv-writev) open "vector.txt"
+(readv-writev) writev 3 buffers
+(readv-writev) file position advanced by writev
+(readv-writev) readv into 2 buffers
+(readv-writev) readv returned written bytes
+(readv-writev) readv with negative count fails
+(readv-writev) close "vector.txt"
+(readv-writev) end
+readv-writev: exit(0)
+EOF
+pass;
@@ -0,0 +1,354 @@
+#include "threads/bench.h"
+
+#include "devices/timer.h"
+#include "threads/malloc.h"
+#include "threads/palloc.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "threads/vaddr.h"
+#ifdef FILESYS
+#include "devices/block.h"
+#endif
+
+#include <debug.h>
+#include <hash.h>
+#include <inttypes.h>
+#include <round.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Kernel microbenchmarks, run by the "bench" action.
+
+	A benchmark performs an operation a given number of times,
+	timing each one separately with the TSC, and the results are
+	reported as one line per benchmark:
+		BENCH <name> ops=<n> min=<c> median=<c> p99=<c> max=<c> median_ns=<t>
+	where the <c> are in TSC cycles per operation and <t> is the
+	median in nanoseconds.  Timer interrupts and the like land in
+	some samples, so compare medians, and watch p99 for the cost
+	of occasional slow paths such as hash table growth.  "null"
+	measures the timing overhead that every sample includes. */
+#define BENCH_DEFAULT_OPS 1000
+#define BENCH_MAX_OPS 16384
+
+/* Function that performs CNT operations, storing the time each
+	took into CYCLES.  AUX is the benchmark's `aux' member.
+	Returns false if the benchmark cannot run in this kernel. */
+typedef bool bench_func(uint32_t cycles[], int cnt, int aux);
+
+/* A benchmark. */
+struct bench {
+	const char* name;			 /* Name, for the "bench" action. */
+	bench_func* func;			 /* Function that runs it. */
+	int aux;						 /* Passed to FUNC. */
+	const char* description; /* What one operation is. */
+};
+
+static bench_func bench_null, bench_ctxsw, bench_lock, bench_malloc, bench_palloc;
+static bench_func bench_hash_insert, bench_hash_find;
+#ifdef FILESYS
+static bench_func bench_block_read;
+#endif
+
+static const struct bench benches[] = {
+	 {"null", bench_null, 0, "nothing: timing overhead"},
+	 {"ctxsw", bench_ctxsw, 0, "semaphore ping-pong between two threads (2 switches)"},
+	 {"lock", bench_lock, 0, "uncontended lock_acquire() and lock_release()"},
+	 {"malloc-16", bench_malloc, 16, "malloc() and free() of 16 bytes"},
+	 {"malloc-64", bench_malloc, 64, "malloc() and free() of 64 bytes"},
+	 {"malloc-256", bench_malloc, 256, "malloc() and free() of 256 bytes"},
+	 {"malloc-1024", bench_malloc, 1024, "malloc() and free() of 1024 bytes"},
+	 {"malloc-4096", bench_malloc, 4096, "malloc() and free() of 4096 bytes (whole pages)"},
+	 {"palloc", bench_palloc, 0, "palloc_get_page() and palloc_free_page()"},
+#ifdef FILESYS
+	 {"block-read-cached", bench_block_read, 0, "block_read() of the same sector each time"},
+	 {"block-read-uncached", bench_block_read, 1, "block_read() of a different sector each time"},
+#endif
+	 {"hash-insert", bench_hash_insert, 0, "hash_insert() into a growing table"},
+	 {"hash-find", bench_hash_find, 0, "hash_find() of a present key"},
+};
+#define BENCH_CNT (sizeof benches / sizeof *benches)
+
+static void run_bench(const struct bench*, int ops);
+static int compare_cycles(const void*, const void*);
+
+/* Runs the benchmark named NAME, performing OPS operations, or
+	the default number if OPS is not positive.  NAME "all" runs
+	every benchmark, and "list" lists them. */
+void bench_run(const char* name, int ops)
+{
+	const struct bench* b;
+
+	if (ops <= 0)
+		ops = BENCH_DEFAULT_OPS;
+	if (ops > BENCH_MAX_OPS)
+		ops = BENCH_MAX_OPS;
+
+	if (!strcmp(name, "list")) {
+		for (b = benches; b < benches + BENCH_CNT; b++) printf("%-20s %s\n", b->name, b->description);
+		return;
+	}
+	for (b = benches; b < benches + BENCH_CNT; b++)
+		if (!strcmp(name, "all") || !strcmp(name, b->name)) {
+			run_bench(b, ops);
+			if (strcmp(name, "all"))
+				return;
+		}
+	if (strcmp(name, "all"))
+		PANIC("no benchmark named \"%s\"", name);
+}
+
+/* Runs benchmark B for OPS operations and prints the results. */
+static void run_bench(const struct bench* b, int ops)
+{
+	size_t page_cnt = DIV_ROUND_UP(ops * sizeof(uint32_t), PGSIZE);
+	uint32_t* cycles = palloc_get_multiple(0, page_cnt);
+	uint64_t median;
+
+	if (cycles == NULL) {
+		printf("BENCH %s skipped: out of memory\n", b->name);
+		return;
+	}
+	if (!b->func(cycles, ops, b->aux)) {
+		printf("BENCH %s skipped: not supported\n", b->name);
+		palloc_free_multiple(cycles, page_cnt);
+		return;
+	}
+
+	qsort(cycles, ops, sizeof *cycles, compare_cycles);
+	median = cycles[ops / 2];
+	printf(
+		 "BENCH %s ops=%d min=%" PRIu32 " median=%" PRIu64 " p99=%" PRIu32 " max=%" PRIu32
+		 " median_ns=%" PRIu64 "\n",
+		 b->name,
+		 ops,
+		 cycles[0],
+		 median,
+		 cycles[ops * 99 / 100],
+		 cycles[ops - 1],
+		 timer_cycles_to_ns(median));
+	palloc_free_multiple(cycles, page_cnt);
+}
+
+/* qsort() comparison function for cycle counts. */
+static int compare_cycles(const void* a_, const void* b_)
+{
+	uint32_t a = *(const uint32_t*) a_;
+	uint32_t b = *(const uint32_t*) b_;
+
+	return a < b ? -1 : a > b;
+}
+
+/* Times nothing, to measure the overhead of timing. */
+static bool bench_null(uint32_t cycles[], int cnt, int aux UNUSED)
+{
+	int i;
+
+	for (i = 0; i < cnt; i++) {
+		uint64_t start = timer_cycles();
+		cycles[i] = timer_cycles() - start;
+	}
+	return true;
+}
+
+/* Semaphore ping-pong for bench_ctxsw(). */
+struct ctxsw {
+	struct semaphore ping; /* Upped by the benchmark. */
+	struct semaphore pong; /* Upped by the helper in reply. */
+	int cnt;					  /* Number of round trips. */
+};
+
+static void ctxsw_helper(void* ctxsw_);
+
+/* Times round trips of a semaphore ping-pong with a helper
+	thread, each of which takes two context switches. */
+static bool bench_ctxsw(uint32_t cycles[], int cnt, int aux UNUSED)
+{
+	struct ctxsw c;
+	int i;
+
+	/* The helper runs at our priority, so that each sema_up()
+		wakes it without preempting us and each sema_down() switches
+		to it. */
+	sema_init(&c.ping, 0);
+	sema_init(&c.pong, 0);
+	c.cnt = cnt;
+	if (thread_create("bench-ctxsw", thread_get_priority(), ctxsw_helper, &c) == TID_ERROR)
+		return false;
+	for (i = 0; i < cnt; i++) {
+		uint64_t start = timer_cycles();
+		sema_up(&c.ping);
+		sema_down(&c.pong);
+		cycles[i] = timer_cycles() - start;
+	}
+	return true;
+}
+
+/* Thread function used by bench_ctxsw(). */
+static void ctxsw_helper(void* ctxsw_)
+{
+	struct ctxsw* c = ctxsw_;
+	int cnt = c->cnt;
+	int i;
+
+	for (i = 0; i < cnt; i++) {
+		sema_down(&c->ping);
+		sema_up(&c->pong);
+	}
+}
+
+/* Times acquiring and releasing an uncontended lock. */
+static bool bench_lock(uint32_t cycles[], int cnt, int aux UNUSED)
+{
+	struct lock lock;
+	int i;
+
+	lock_init_named(&lock, "bench");
+	for (i = 0; i < cnt; i++) {
+		uint64_t start = timer_cycles();
+		lock_acquire(&lock);
+		lock_release(&lock);
+		cycles[i] = timer_cycles() - start;
+	}
+	return true;
+}
+
+/* Times allocating and freeing a block of SIZE bytes. */
+static bool bench_malloc(uint32_t cycles[], int cnt, int size)
+{
+	int i;
+
+	for (i = 0; i < cnt; i++) {
+		uint64_t start = timer_cycles();
+		void* p = malloc(size);
+		free(p);
+		cycles[i] = timer_cycles() - start;
+		if (p == NULL)
+			return false;
+	}
+	return true;
+}
+
+/* Times allocating and freeing a page. */
+static bool bench_palloc(uint32_t cycles[], int cnt, int aux UNUSED)
+{
+	int i;
+
+	for (i = 0; i < cnt; i++) {
+		uint64_t start = timer_cycles();
+		void* page = palloc_get_page(0);
+		palloc_free_page(page);
+		cycles[i] = timer_cycles() - start;
+		if (page == NULL)
+			return false;
+	}
+	return true;
+}
+
+#ifdef FILESYS
+/* Times reading a sector of the file system device: the same
+	sector each time if UNCACHED is zero, otherwise sectors
+	strided across the device.  There is no buffer cache, so
+	"cached" reads hit only the disk's cache, or the emulator's,
+	which the stride defeats. */
+static bool bench_block_read(uint32_t cycles[], int cnt, int uncached)
+{
+	struct block* block = block_get_role(BLOCK_FILESYS);
+	void* buffer;
+	int i;
+
+	if (block == NULL)
+		return false;
+	buffer = malloc(BLOCK_SECTOR_SIZE);
+	if (buffer == NULL)
+		return false;
+
+	for (i = 0; i < cnt; i++) {
+		block_sector_t sector = uncached ? (uint64_t) i * 4099 % block_size(block) : 0;
+		uint64_t start = timer_cycles();
+		block_read(block, sector, buffer);
+		cycles[i] = timer_cycles() - start;
+	}
+	free(buffer);
+	return true;
+}
+#endif
+
+/* Element of the tables in the hash benchmarks. */
+struct bench_elem {
+	struct hash_elem elem;
+	int key;
+};
+
+/* Hash function for bench_elem. */
+static unsigned bench_elem_hash(const struct hash_elem* e, void* aux UNUSED)
+{
+	return hash_int(hash_entry(e, struct bench_elem, elem)->key);
+}
+
+/* Comparison function for bench_elem. */
+static bool bench_elem_less(const struct hash_elem* a, const struct hash_elem* b, void* aux UNUSED)
+{
+	return hash_entry(a, struct bench_elem, elem)->key < hash_entry(b, struct bench_elem, elem)->key;
+}
+
+/* Inserts CNT elements, with keys 0 through CNT - 1, into H,
+	timing each insertion into CYCLES if it is nonnull.  Returns
+	the elements, or a null pointer if memory is short. */
+static struct bench_elem* hash_fill(struct hash* h, int cnt, uint32_t cycles[])
+{
+	struct bench_elem* elems = malloc(cnt * sizeof *elems);
+	int i;
+
+	if (elems == NULL)
+		return NULL;
+	if (!hash_init(h, bench_elem_hash, bench_elem_less, NULL)) {
+		free(elems);
+		return NULL;
+	}
+	for (i = 0; i < cnt; i++) {
+		uint64_t start = timer_cycles();
+		elems[i].key = i;
+		hash_insert(h, &elems[i].elem);
+		if (cycles != NULL)
+			cycles[i] = timer_cycles() - start;
+	}
+	return elems;
+}
+
+/* Times inserting keys into a hash table as it grows. */
+static bool bench_hash_insert(uint32_t cycles[], int cnt, int aux UNUSED)
+{
+	struct hash h;
+	struct bench_elem* elems = hash_fill(&h, cnt, cycles);
+
+	if (elems == NULL)
+		return false;
+	hash_destroy(&h, NULL);
+	free(elems);
+	return true;
+}
+
+/* Times finding each of the keys in a hash table. */
+static bool bench_hash_find(uint32_t cycles[], int cnt, int aux UNUSED)
+{
+	struct hash h;
+	struct bench_elem* elems = hash_fill(&h, cnt, NULL);
+	int i;
+
+	if (elems == NULL)
+		return false;
+	for (i = 0; i < cnt; i++) {
+		struct bench_elem key;
+		uint64_t start;
+
+		key.key = i;
+		start = timer_cycles();
+		hash_find(&h, &key.elem);
+		cycles[i] = timer_cycles() - start;
+	}
+	hash_destroy(&h, NULL);
+	free(elems);
+	return true;
+}
@@ -0,0 +1,6 @@
+#ifndef THREADS_BENCH_H
+#define THREADS_BENCH_H
+
+void bench_run(const char* name, int ops);
+
+#endif /* threads/bench.h */
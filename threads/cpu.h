@@ -0,0 +1,58 @@
+#ifndef THREADS_CPU_H
+#define THREADS_CPU_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+struct thread;
+struct trace_record;
+
+/* Maximum number of CPUs.  smp_init() finds how many the machine
+	has, up to this many. */
+#define CPU_MAX 8
+
+/* Per-CPU scheduler state.  Code that would otherwise keep
+	scheduler state in a global variable keeps it here, so that
+	each CPU has its own. */
+struct cpu {
+	int id;								/* Index in cpus[]. */
+	uint8_t apic_id;					/* Local APIC ID, for IPIs. */
+	bool started;						/* Running the scheduler yet? */
+	struct thread* idle_thread;	/* Runs when nothing else is ready. */
+	struct thread* curr;				/* Running thread. */
+	unsigned thread_ticks;			/* # of timer ticks since last yield. */
+	int64_t ticks;						/* # of timer ticks on this CPU. */
+	int64_t switch_ns;				/* When the running thread was switched to. */
+
+	/* Interrupt state, owned by interrupt.c. */
+	bool in_external_intr; /* Processing an external interrupt? */
+	bool yield_on_return;  /* Yield on interrupt return? */
+	bool in_softirq;		  /* Running softirqs? */
+
+	/* Interrupts-off tracer, owned by interrupt.c. */
+	uint64_t irqsoff_start; /* TSC when intr_disable() ran, or 0. */
+	void* irqsoff_caller;	/* Code that called intr_disable(). */
+
+	/* Trace buffer, owned by trace.c. */
+	struct trace_record* trace_ring; /* TRACE_RING_CNT records. */
+	unsigned trace_head;					/* Number of records ever claimed. */
+};
+
+extern struct cpu cpus[CPU_MAX];
+extern int cpu_cnt; /* Number of CPUs in cpus[]. */
+
+/* Returns the CPU we are running on.  The caller should disable
+	interrupts, or otherwise keep the running thread from
+	migrating, for as long as it uses the result. */
+struct cpu* cpu_current(void);
+
+/* Returns the CPU's time-stamp counter, which counts clock
+	cycles since reset.  See [IA32-v2b] "RDTSC". */
+static inline uint64_t rdtsc(void)
+{
+	uint64_t tsc;
+	asm volatile("rdtsc" : "=A"(tsc));
+	return tsc;
+}
+
+#endif /* threads/cpu.h */
@@ -0,0 +1,86 @@
+#ifndef THREADS_FIXED_POINT_H
+#define THREADS_FIXED_POINT_H
+
+#include <stdint.h>
+
+/* Signed 17.14 fixed-point arithmetic, as used by the 4.4BSD
+	scheduler for load_avg and recent_cpu.  A fixed_t holds a real
+	number X as the integer X * FP_F, leaving 17 bits for the
+	integer part and 14 for the fraction.
+
+	The kernel has no floating point, so this is the only way to
+	compute the scheduler's fractional quantities.  Products and
+	quotients of two fixed_t values go through 64-bit
+	intermediates to avoid overflow. */
+typedef int32_t fixed_t;
+
+#define FP_Q 14				 /* Number of fraction bits. */
+#define FP_F (1 << FP_Q) /* Fixed-point representation of 1. */
+
+/* Converts integer N to fixed point. */
+static inline fixed_t fp_from_int(int n)
+{
+	return n * FP_F;
+}
+
+/* Converts X to an integer, rounding toward zero. */
+static inline int fp_to_int(fixed_t x)
+{
+	return x / FP_F;
+}
+
+/* Converts X to an integer, rounding to nearest. */
+static inline int fp_round(fixed_t x)
+{
+	return x >= 0 ? (x + FP_F / 2) / FP_F : (x - FP_F / 2) / FP_F;
+}
+
+/* Returns X + Y. */
+static inline fixed_t fp_add(fixed_t x, fixed_t y)
+{
+	return x + y;
+}
+
+/* Returns X - Y. */
+static inline fixed_t fp_sub(fixed_t x, fixed_t y)
+{
+	return x - y;
+}
+
+/* Returns X + N, for integer N. */
+static inline fixed_t fp_add_int(fixed_t x, int n)
+{
+	return x + n * FP_F;
+}
+
+/* Returns X - N, for integer N. */
+static inline fixed_t fp_sub_int(fixed_t x, int n)
+{
+	return x - n * FP_F;
+}
+
+/* Returns X * Y. */
+static inline fixed_t fp_mul(fixed_t x, fixed_t y)
+{
+	return ((int64_t) x) * y / FP_F;
+}
+
+/* Returns X * N, for integer N. */
+static inline fixed_t fp_mul_int(fixed_t x, int n)
+{
+	return x * n;
+}
+
+/* Returns X / Y. */
+static inline fixed_t fp_div(fixed_t x, fixed_t y)
+{
+	return ((int64_t) x) * FP_F / y;
+}
+
+/* Returns X / N, for integer N. */
+static inline fixed_t fp_div_int(fixed_t x, int n)
+{
+	return x / n;
+}
+
+#endif /* threads/fixed-point.h */
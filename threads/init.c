@@ -7,13 +7,18 @@
 #include "devices/shutdown.h"
 #include "devices/timer.h"
 #include "devices/vga.h"
+#include "threads/bench.h"
 #include "threads/interrupt.h"
 #include "threads/io.h"
 #include "threads/loader.h"
 #include "threads/malloc.h"
 #include "threads/palloc.h"
+#include "threads/profile.h"
 #include "threads/pte.h"
+#include "threads/smp.h"
 #include "threads/thread.h"
+#include "threads/trace.h"
+#include "threads/workqueue.h"
 
 #include <console.h>
 #include <debug.h>
@@ -63,6 +68,9 @@ static uint16_t init_timer_freq = 1000;
 /* -S: Execute kernel thread slowly */
 static bool slow_kernel_threads = false;
 
+/* -trace: Record tracepoints? */
+static bool trace_option;
+
 /* -tcl: Set limit on threads that can be created */
 int thread_create_limit = 0; /* Infinite */
 /* -fl: Maximum number of pages to put into palloc's free pool */
@@ -110,6 +118,9 @@ int main(void)
 	palloc_init(user_page_limit, free_page_limit);
 	malloc_init();
 	paging_init();
+	smp_init();
+	if (trace_option)
+		trace_start();
 
 	/* Segmentation. */
 #ifdef USERPROG
@@ -132,8 +143,11 @@ int main(void)
 
 	/* Start thread scheduler and enable interrupts. */
 	thread_start();
+	intr_softirq_start();
+	workqueue_init();
 	serial_init_queue();
 	timer_calibrate();
+	smp_start();
 
 #ifdef FILESYS
 	/* Initialize file system. */
@@ -268,6 +282,18 @@ static char** parse_options(char** argv)
 			random_init(atoi(value));
 		else if (!strcmp(name, "-mlfqs"))
 			thread_mlfqs = true;
+		else if (!strcmp(name, "-cfs"))
+			thread_cfs = true;
+		else if (!strcmp(name, "-tickless"))
+			timer_tickless = true;
+		else if (!strcmp(name, "-irqsoff"))
+			intr_irqsoff_trace = true;
+		else if (!strcmp(name, "-profile"))
+			profile_interval = atoi(value);
+		else if (!strcmp(name, "-trace"))
+			trace_option = true;
+		else if (!strcmp(name, "-cpus"))
+			smp_cpu_limit = atoi(value);
 #ifdef USERPROG
 		else if (!strcmp(name, "-ul"))
 			user_page_limit = atoi(value);
@@ -275,10 +301,14 @@ static char** parse_options(char** argv)
 			free_page_limit = atoi(value);
 		else if (!strcmp(name, "-tcl"))
 			thread_create_limit = atoi(value);
+		else if (!strcmp(name, "-sysstats"))
+			syscall_exit_stats = true;
 #endif
 		else
 			PANIC("unknown option `%s' (use -h for help)", name);
 	}
+	if (thread_mlfqs && thread_cfs)
+		PANIC("options -mlfqs and -cfs are mutually exclusive");
 
 	/* Initialize the random number generator based on the system
 		time.  This has no effect if an "-rs" option was specified.
@@ -307,6 +337,19 @@ static void run_task(char** argv)
 	printf("Execution of '%s' complete.\n", task);
 }
 
+/* Runs the benchmark specified in ARGV[1], as its name
+	optionally followed by a number of operations. */
+static void run_bench(char** argv)
+{
+	char* save_ptr;
+	char* name = strtok_r(argv[1], " ", &save_ptr);
+	char* ops = strtok_r(NULL, " ", &save_ptr);
+
+	if (name == NULL)
+		PANIC("action `bench' requires a benchmark name");
+	bench_run(name, ops != NULL ? atoi(ops) : 0);
+}
+
 /* Executes all of the actions specified in ARGV[]
 	up to the null pointer sentinel. */
 static void run_actions(char** argv)
@@ -321,6 +364,7 @@ static void run_actions(char** argv)
 	/* Table of supported actions. */
 	static const struct action actions[] = {
 		 {"run", 2, run_task},
+		 {"bench", 2, run_bench},
 #ifdef FILESYS
 		 {"ls", 1, fsutil_ls},
 		 {"cat", 2, fsutil_cat},
@@ -371,6 +415,8 @@ static void usage(void)
 #else
 		 "  run TEST           Run TEST.\n"
 #endif
+		 "  bench 'NAME [OPS]' Run benchmark NAME for OPS operations.\n"
+		 "                     NAME `all' runs every benchmark, `list' lists them.\n"
 #ifdef FILESYS
 		 "  ls                 List files in the root directory.\n"
 		 "  cat FILE           Print FILE to the console.\n"
@@ -394,11 +440,18 @@ static void usage(void)
 #endif
 		 "  -rs=SEED           Set random number seed to SEED.\n"
 		 "  -mlfqs             Use multi-level feedback queue scheduler.\n"
+		 "  -cfs               Use completely fair scheduler.\n"
+		 "  -tickless          Use one-shot timer interrupts, skip ticks when idle.\n"
+		 "  -irqsoff           Trace the longest windows with interrupts off.\n"
+		 "  -profile=TICKS     Sample the running code every TICKS timer ticks.\n"
+		 "  -trace             Record tracepoints, dump them at shutdown.\n"
+		 "  -cpus=N            Use at most N CPUs (default: 1).\n"
 		 "  -F=FREQ            Set the system timer to FREQ frequency.\n"
 		 "  -tcl=COUNT         Limit the number of threads to COUNT.\n"
 		 "  -fl=COUNT          Limit system memory to COUNT pages.\n"
 #ifdef USERPROG
 		 "  -ul=COUNT          Limit user memory to COUNT pages.\n"
+		 "  -sysstats          Print each process's syscall statistics at exit.\n"
 #endif
 	);
 	shutdown_power_off();
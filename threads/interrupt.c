@@ -1,9 +1,12 @@
 #include "threads/interrupt.h"
 
 #include "devices/timer.h"
+#include "threads/cpu.h"
 #include "threads/flags.h"
 #include "threads/intr-stubs.h"
 #include "threads/io.h"
+#include "threads/lapic.h"
+#include "threads/spinlock.h"
 #include "threads/thread.h"
 #include "threads/vaddr.h"
 
@@ -39,15 +42,95 @@ static const char* intr_names[INTR_CNT];
 	unexpected interrupt is one that has no registered handler. */
 static unsigned int unexpected_cnt[INTR_CNT];
 
+/* Number of times each interrupt's handler has run, and the
+	time it took, in TSC cycles, as a total, a maximum, and a log2
+	histogram: bucket 0 counts runs under 1 cycle, and bucket I >
+	0 counts runs from 2**(I-1) up to 2**I cycles, except that the
+	last bucket also counts everything longer.  For internal
+	interrupts that run with interrupts on, such as system calls,
+	the time includes any time the handler spent blocked. */
+#define INTR_HIST_BUCKETS 28
+static unsigned intr_cnt[INTR_CNT];
+static uint64_t intr_cycles[INTR_CNT];
+static uint64_t intr_max_cycles[INTR_CNT];
+static unsigned intr_hist[INTR_CNT][INTR_HIST_BUCKETS];
+
+/* Interrupts-off tracer.  Each window starts when intr_disable()
+	turns interrupts off and ends when they next come back on,
+	perhaps in another thread, and is charged to the code that
+	called intr_disable().  Only the longest window of each of the
+	IRQSOFF_TOP_CNT worst callers is kept, longest first.
+	Interrupt handlers entered with interrupts on are not counted
+	as windows; intr_print_stats() reports their times instead. */
+#define IRQSOFF_TOP_CNT 10
+bool intr_irqsoff_trace;
+struct irqsoff_window {
+	uint64_t cycles; /* Length, in TSC cycles. */
+	void* caller;	  /* Code that called intr_disable(). */
+};
+static struct irqsoff_window irqsoff_top[IRQSOFF_TOP_CNT];
+static unsigned irqsoff_cnt; /* Number of windows traced. */
+
+/* The big kernel lock.  Until the kernel's data get locks of
+	their own, at most one CPU at a time runs with interrupts off:
+	turning interrupts off with intr_disable(), or on entry to an
+	interrupt handler, acquires this lock, and turning them back
+	on releases it.  So code that turns interrupts off to keep
+	interrupt handlers away from shared data on one CPU also
+	keeps the other CPUs away from it.  Code running with
+	interrupts on holds no lock and runs on all CPUs at once.
+
+	The lock belongs to the CPU, not to a thread: a thread that
+	switches away with interrupts off hands it to the thread it
+	switches to.  The bootstrap processor holds it from boot,
+	when interrupts are off, until it first turns them on.
+
+	With a single CPU there is no one to lock out, so bkl_acquire()
+	and bkl_release() leave the lock alone while cpu_cnt is 1. */
+static struct spinlock big_kernel_lock = {1, "big kernel lock"};
+
 /* External interrupts are those generated by devices outside the
-	CPU, such as the timer.  External interrupts run with
-	interrupts turned off, so they never nest, nor are they ever
-	pre-empted.  Handlers for external interrupts also may not
-	sleep, although they may invoke intr_yield_on_return() to
-	request that a new process be scheduled just before the
-	interrupt returns. */
-static bool in_external_intr; /* Are we processing an external interrupt? */
-static bool yield_on_return;	/* Should we yield on interrupt return? */
+	CPU, such as the timer, and by the local APIC of each CPU.
+	External interrupts run with interrupts turned off, so they
+	never nest, nor are they ever pre-empted.  Handlers for
+	external interrupts also may not sleep, although they may
+	invoke intr_yield_on_return() to request that a new process be
+	scheduled just before the interrupt returns.  Whether a CPU is
+	processing one is kept in its struct cpu. */
+
+/* Softirqs.  intr_raise_softirq() marks a softirq pending, and
+	intr_handler() runs pending softirqs after the external
+	interrupt handler returns, with interrupts back on, before
+	the interrupt itself returns.  An interrupt that arrives while
+	softirqs run leaves any softirqs it raises to the loop it
+	interrupted, so softirqs never nest.
+
+	Softirqs raised again and again, as under heavy interrupt
+	load, could keep the interrupted thread from running at all.
+	So after SOFTIRQ_MAX_ROUNDS passes over the pending softirqs,
+	the rest are handed to the "softirqd" kernel thread, which
+	runs them at the default priority, yielding between passes,
+	and until it has caught up interrupt returns leave softirqs
+	to it.
+
+	Softirqs count as interrupt context: they may not sleep, and
+	a thread woken by one preempts the running thread only once
+	all the softirqs have run.  They run on one CPU at a time. */
+#define SOFTIRQ_MAX_ROUNDS 10
+struct softirq_action {
+	softirq_func* func;	/* Function to run. */
+	const char* name;		/* Name, for statistics. */
+	unsigned raised;		/* Number of times raised. */
+	unsigned runs;			/* Number of times run. */
+	uint64_t cycles;		/* Total run time, in TSC cycles. */
+	uint64_t max_cycles; /* Longest run time, in TSC cycles. */
+};
+static struct softirq_action softirqs[SOFTIRQ_CNT];
+static unsigned softirq_pending;	  /* Bit N set if softirq N is pending. */
+static bool softirq_running;		  /* Is some CPU running softirqs? */
+static struct thread* softirqd;	  /* Runs deferred softirqs. */
+static bool softirqd_active;		  /* Softirqs handed to softirqd? */
+static unsigned softirq_deferrals; /* Number of hand-offs to softirqd. */
 
 /* Programmable Interrupt Controller helpers. */
 static void pic_init(void);
@@ -57,10 +140,32 @@ static void pic_end_of_interrupt(int irq);
 static uint64_t make_intr_gate(void (*)(void), int dpl);
 static uint64_t make_trap_gate(void (*)(void), int dpl);
 static inline uint64_t make_idtr_operand(uint16_t limit, void* base);
+static void idt_load(void);
 
 /* Interrupt handlers. */
 void intr_handler(struct intr_frame* args);
 static void unexpected_interrupt(const struct intr_frame*);
+static void intr_account(uint8_t vec_no, uint64_t cycles);
+static bool softirq_run(void);
+static void softirqd_wake(void);
+static void softirqd_func(void* aux);
+
+/* Interrupts-off tracer. */
+static enum intr_level disable_from(void* caller);
+
+/* Acquires the big kernel lock, if there is more than one CPU. */
+static inline void bkl_acquire(void)
+{
+	if (cpu_cnt > 1)
+		spin_acquire(&big_kernel_lock);
+}
+
+/* Releases the big kernel lock, if there is more than one CPU. */
+static inline void bkl_release(void)
+{
+	if (cpu_cnt > 1)
+		spin_release(&big_kernel_lock);
+}
 
 /* Returns the current interrupt status. */
 enum intr_level intr_get_level(void)
@@ -80,14 +185,21 @@ enum intr_level intr_get_level(void)
 	returns the previous interrupt status. */
 enum intr_level intr_set_level(enum intr_level level)
 {
-	return level == INTR_ON ? intr_enable() : intr_disable();
+	return level == INTR_ON ? intr_enable() : disable_from(__builtin_return_address(0));
 }
 
 /* Enables interrupts and returns the previous interrupt status. */
 enum intr_level intr_enable(void)
 {
 	enum intr_level old_level = intr_get_level();
-	ASSERT(!intr_context());
+	ASSERT(old_level == INTR_ON || !cpu_current()->in_external_intr);
+
+	/* Release the big kernel lock before an interrupt can come in
+		and try to acquire it. */
+	if (old_level == INTR_OFF) {
+		intr_irqsoff_end();
+		bkl_release();
+	}
 
 	/* Enable interrupts by setting the interrupt flag.
 
@@ -100,6 +212,14 @@ enum intr_level intr_enable(void)
 
 /* Disables interrupts and returns the previous interrupt status. */
 enum intr_level intr_disable(void)
+{
+	return disable_from(__builtin_return_address(0));
+}
+
+/* Disables interrupts on behalf of CALLER, which the
+	interrupts-off tracer charges for the window if this starts
+	one, and returns the previous interrupt status. */
+static enum intr_level disable_from(void* caller)
 {
 	enum intr_level old_level = intr_get_level();
 
@@ -108,13 +228,75 @@ enum intr_level intr_disable(void)
 		Hardware Interrupts". */
 	asm volatile("cli" : : : "memory");
 
+	if (old_level == INTR_ON) {
+		bkl_acquire();
+		if (intr_irqsoff_trace) {
+			struct cpu* c = cpu_current();
+			c->irqsoff_start = rdtsc();
+			c->irqsoff_caller = caller;
+		}
+	}
+
 	return old_level;
 }
 
+/* Turns interrupts on and waits for the next one.  Must be
+	called with interrupts off.  Used by idle threads. */
+void intr_halt(void)
+{
+	ASSERT(intr_get_level() == INTR_OFF);
+
+	intr_irqsoff_end();
+	bkl_release();
+
+	/* The `sti' instruction disables interrupts until the
+		completion of the next instruction, so these two
+		instructions are executed atomically.  This atomicity is
+		important; otherwise, an interrupt could be handled between
+		re-enabling interrupts and waiting for the next one to
+		occur, wasting as much as one clock tick worth of time.
+
+		See [IA32-v2a] "HLT", [IA32-v2b] "STI", and [IA32-v3a]
+		7.11.1 "HLT Instruction". */
+	asm volatile("sti; hlt" : : : "memory");
+}
+
+/* Ends the interrupts-off window being traced, if any.  Must be
+	called with interrupts off, just before they are turned back
+	on.  intr_enable() and interrupt return do this themselves;
+	only code that enables interrupts some other way, such as
+	with `sti', needs to call this function. */
+void intr_irqsoff_end(void)
+{
+	struct cpu* c = cpu_current();
+	uint64_t cycles;
+	void* caller;
+	int i;
+
+	ASSERT(intr_get_level() == INTR_OFF);
+
+	if (c->irqsoff_start == 0)
+		return;
+	cycles = rdtsc() - c->irqsoff_start;
+	caller = c->irqsoff_caller;
+	c->irqsoff_start = 0;
+	irqsoff_cnt++;
+
+	/* Replace CALLER's entry if it has one, otherwise the
+		shortest, and keep the entries sorted. */
+	for (i = 0; i < IRQSOFF_TOP_CNT - 1; i++)
+		if (irqsoff_top[i].caller == caller)
+			break;
+	if (cycles <= irqsoff_top[i].cycles)
+		return;
+	for (; i > 0 && irqsoff_top[i - 1].cycles < cycles; i--) irqsoff_top[i] = irqsoff_top[i - 1];
+	irqsoff_top[i].cycles = cycles;
+	irqsoff_top[i].caller = caller;
+}
+
 /* Initializes the interrupt system. */
 void intr_init(void)
 {
-	uint64_t idtr_operand;
 	int i;
 
 	/* Initialize interrupt controller. */
@@ -122,12 +304,7 @@ void intr_init(void)
 
 	/* Initialize IDT. */
 	for (i = 0; i < INTR_CNT; i++) idt[i] = make_intr_gate(intr_stubs[i], 0);
-
-	/* Load IDT register.
-		See [IA32-v2a] "LIDT" and [IA32-v3a] 5.10 "Interrupt
-		Descriptor Table (IDT)". */
-	idtr_operand = make_idtr_operand(sizeof idt - 1, idt);
-	asm volatile("lidt %0" : : "m"(idtr_operand));
+	idt_load();
 
 	/* Initialize intr_names. */
 	for (i = 0; i < INTR_CNT; i++) intr_names[i] = "unknown";
@@ -152,6 +329,28 @@ void intr_init(void)
 	intr_names[19] = "#XF SIMD Floating-Point Exception";
 }
 
+/* Sets up interrupts on an application processor, which shares
+	the IDT set up by intr_init(), and acquires the big kernel
+	lock, as if the processor had booted with interrupts off
+	holding it like the bootstrap processor.  Must be called with
+	interrupts off. */
+void intr_init_ap(void)
+{
+	ASSERT(intr_get_level() == INTR_OFF);
+
+	idt_load();
+	bkl_acquire();
+}
+
+/* Loads the IDT register.
+	See [IA32-v2a] "LIDT" and [IA32-v3a] 5.10 "Interrupt
+	Descriptor Table (IDT)". */
+static void idt_load(void)
+{
+	uint64_t idtr_operand = make_idtr_operand(sizeof idt - 1, idt);
+	asm volatile("lidt %0" : : "m"(idtr_operand));
+}
+
 /* Registers interrupt VEC_NO to invoke HANDLER with descriptor
 	privilege level DPL.  Names the interrupt NAME for debugging
 	purposes.  The interrupt handler will be invoked with
@@ -181,6 +380,17 @@ void intr_register_ext(uint8_t vec_no, intr_handler_func* handler, const char* n
 	register_handler(vec_no, 0, INTR_OFF, handler, name);
 }
 
+/* Registers local APIC interrupt VEC_NO, such as the local APIC
+	timer or an inter-processor interrupt, to invoke HANDLER,
+	which is named NAME for debugging purposes.  Local APIC
+	interrupts are external interrupts delivered to a single CPU,
+	and their handlers execute with interrupts disabled. */
+void intr_register_local(uint8_t vec_no, intr_handler_func* handler, const char* name)
+{
+	ASSERT(vec_no >= LAPIC_VEC_MIN);
+	register_handler(vec_no, 0, INTR_OFF, handler, name);
+}
+
 /* Clear registration for VEC_NO to re-register it later. */
 void intr_clear_int(uint8_t vec_no)
 {
@@ -221,21 +431,35 @@ void intr_register_int(
 	register_handler(vec_no, dpl, level, handler, name);
 }
 
-/* Returns true during processing of an external interrupt
-	and false at all other times. */
+/* Returns true during processing of an external interrupt or
+	of softirqs and false at all other times. */
 bool intr_context(void)
 {
-	return in_external_intr;
+	struct cpu* c;
+	uint32_t flags;
+	bool context;
+
+	/* Keep the running thread from moving to another CPU between
+		finding its CPU and reading the CPU's state.  Plain `cli'
+		suffices, because no other CPU writes that state, and
+		intr_disable() would needlessly take the big kernel lock. */
+	asm volatile("pushfl; cli; popl %0" : "=r"(flags) : : "memory");
+	c = cpu_current();
+	context = c->in_external_intr || c->in_softirq;
+	if (flags & FLAG_IF)
+		asm volatile("sti" : : : "memory");
+	return context;
 }
 
 /* During processing of an external interrupt, directs the
 	interrupt handler to yield to a new process just before
-	returning from the interrupt.  May not be called at any other
-	time. */
+	returning from the interrupt.  During processing of softirqs,
+	yields once they have all run.  May not be called at any
+	other time. */
 void intr_yield_on_return(void)
 {
 	ASSERT(intr_context());
-	yield_on_return = true;
+	cpu_current()->yield_on_return = true;
 }
 
 /* 8259A Programmable Interrupt Controller. */
@@ -354,43 +578,262 @@ void intr_handler(struct intr_frame* frame)
 {
 	bool external;
 	intr_handler_func* handler;
+	struct cpu* c = cpu_current();
+	uint64_t start;
+
+	/* Entering an interrupt gate turned interrupts off, so take
+		the big kernel lock, as intr_disable() would have. */
+	if ((frame->eflags & FLAG_IF) && intr_get_level() == INTR_OFF)
+		bkl_acquire();
+	start = rdtsc();
 
 	/* External interrupts are special.
 		We only handle one at a time (so interrupts must be off)
-		and they need to be acknowledged on the PIC (see below).
-		An external interrupt handler cannot sleep. */
-	external = frame->vec_no >= 0x20 && frame->vec_no < 0x30;
+		and they need to be acknowledged on the PIC or the local
+		APIC (see below).  An external interrupt handler cannot
+		sleep. */
+	external = (frame->vec_no >= 0x20 && frame->vec_no < 0x30) || frame->vec_no >= LAPIC_VEC_MIN;
 	if (external) {
 		ASSERT(intr_get_level() == INTR_OFF);
-		ASSERT(!intr_context());
+		ASSERT(!c->in_external_intr);
 
-		in_external_intr = true;
-		yield_on_return = false;
+		c->in_external_intr = true;
+		if (!c->in_softirq)
+			c->yield_on_return = false;
+
+		/* Any interrupt may wake a thread, so restart the tick if
+			the idle thread stopped it.  The tick, and devices, are
+			the bootstrap processor's. */
+		if (c->id == 0)
+			timer_idle_exit(frame->vec_no);
 	}
 
 	/* Invoke the interrupt's handler. */
 	handler = intr_handlers[frame->vec_no];
 	if (handler != NULL)
 		handler(frame);
-	else if (frame->vec_no == 0x27 || frame->vec_no == 0x2f) {
+	else if (frame->vec_no == 0x27 || frame->vec_no == 0x2f || frame->vec_no == LAPIC_SPURIOUS_VEC) {
 		/* There is no handler, but this interrupt can trigger
 			spuriously due to a hardware fault or hardware race
 			condition.  Ignore it. */
 	}
 	else
 		unexpected_interrupt(frame);
+	intr_account(frame->vec_no, rdtsc() - start);
 
 	/* Complete the processing of an external interrupt. */
 	if (external) {
 		ASSERT(intr_get_level() == INTR_OFF);
 		ASSERT(intr_context());
 
-		in_external_intr = false;
-		pic_end_of_interrupt(frame->vec_no);
+		c->in_external_intr = false;
+		if (frame->vec_no < 0x30)
+			pic_end_of_interrupt(frame->vec_no);
+		else if (frame->vec_no != LAPIC_SPURIOUS_VEC)
+			lapic_eoi();
+
+		/* An interrupt that arrived while softirqs were running
+			leaves both its softirqs and any yield to them. */
+		if (!c->in_softirq) {
+			if (softirq_pending != 0 && !softirqd_active && !softirq_running && softirq_run())
+				softirqd_wake();
+			if (c->yield_on_return)
+				thread_yield();
+		}
+	}
+
+	/* Returning turns interrupts back on if they were on when the
+		interrupt arrived, which releases the big kernel lock.
+		After a thread switch, a window opened in another thread,
+		perhaps on another CPU, may end here. */
+	if ((frame->eflags & FLAG_IF) && intr_get_level() == INTR_OFF) {
+		intr_irqsoff_end();
+		bkl_release();
+	}
+}
+
+/* Registers softirq SOFTIRQ to invoke FUNC, which is named NAME
+	for statistics. */
+void intr_register_softirq(enum softirq softirq, softirq_func* func, const char* name)
+{
+	ASSERT(softirq < SOFTIRQ_CNT);
+	ASSERT(softirqs[softirq].func == NULL);
+
+	softirqs[softirq].func = func;
+	softirqs[softirq].name = name;
+}
+
+/* Marks SOFTIRQ pending, so that it runs once the current
+	external interrupt handler returns, or soon if called outside
+	an interrupt handler.  Raising a softirq that is already
+	pending has no further effect. */
+void intr_raise_softirq(enum softirq softirq)
+{
+	enum intr_level old_level;
+
+	ASSERT(softirq < SOFTIRQ_CNT);
+	ASSERT(softirqs[softirq].func != NULL);
+
+	old_level = intr_disable();
+	softirq_pending |= 1u << softirq;
+	softirqs[softirq].raised++;
+	if (!intr_context())
+		softirqd_wake();
+	intr_set_level(old_level);
+}
+
+/* Starts softirqd, the thread that takes over softirqs under
+	load.  Until then, softirqs always run on interrupt return.
+	Must be called after thread_start(). */
+void intr_softirq_start(void)
+{
+	thread_create("softirqd", PRI_DEFAULT, softirqd_func, NULL);
+}
+
+/* Runs pending softirqs with interrupts on, making up to
+	SOFTIRQ_MAX_ROUNDS passes as long as more are raised.  Returns
+	true if softirqs are still pending.  Must be called with
+	interrupts off, and returns with interrupts off. */
+static bool softirq_run(void)
+{
+	struct cpu* c = cpu_current();
+	int round;
+
+	ASSERT(intr_get_level() == INTR_OFF);
+	ASSERT(!softirq_running);
+
+	/* Interrupts that come in while softirqs run defer yields
+		until they are done, so we stay on this CPU. */
+	c->in_softirq = softirq_running = true;
+	for (round = 0; round < SOFTIRQ_MAX_ROUNDS && softirq_pending != 0; round++) {
+		unsigned pending = softirq_pending;
+		int i;
+
+		softirq_pending = 0;
+		intr_enable();
+		for (i = 0; i < SOFTIRQ_CNT; i++)
+			if (pending & (1u << i)) {
+				struct softirq_action* s = &softirqs[i];
+				uint64_t start = rdtsc();
+				uint64_t cycles;
+
+				s->func();
+				cycles = rdtsc() - start;
+				s->runs++;
+				s->cycles += cycles;
+				if (cycles > s->max_cycles)
+					s->max_cycles = cycles;
+			}
+		intr_disable();
+	}
+	c->in_softirq = softirq_running = false;
+
+	return softirq_pending != 0;
+}
+
+/* Hands pending softirqs to softirqd, if it has been started.
+	Must be called with interrupts off. */
+static void softirqd_wake(void)
+{
+	ASSERT(intr_get_level() == INTR_OFF);
+
+	if (softirqd == NULL || softirqd_active)
+		return;
+	softirqd_active = true;
+	softirq_deferrals++;
+	thread_unblock(softirqd);
+}
 
-		if (yield_on_return)
-			thread_yield();
+/* softirqd thread.  Runs softirqs while interrupt returns leave
+	them to it, yielding between batches, and sleeps once none
+	are pending. */
+static void softirqd_func(void* aux UNUSED)
+{
+	intr_disable();
+	softirqd = thread_current();
+	for (;;) {
+		if (softirq_pending == 0) {
+			softirqd_active = false;
+			thread_block();
+			continue;
+		}
+		if (!softirq_running) {
+			/* Otherwise another CPU is running them already. */
+			cpu_current()->yield_on_return = false;
+			softirq_run();
+		}
+		intr_enable();
+		thread_yield();
+		intr_disable();
+	}
+}
+
+/* Charges a run of CYCLES TSC cycles to the handler of
+	interrupt VEC_NO. */
+static void intr_account(uint8_t vec_no, uint64_t cycles)
+{
+	enum intr_level old_level;
+	int bucket = 0;
+	uint64_t c;
+
+	for (c = cycles; c > 0 && bucket < INTR_HIST_BUCKETS - 1; c >>= 1) bucket++;
+
+	old_level = intr_disable();
+	intr_cnt[vec_no]++;
+	intr_cycles[vec_no] += cycles;
+	if (cycles > intr_max_cycles[vec_no])
+		intr_max_cycles[vec_no] = cycles;
+	intr_hist[vec_no][bucket]++;
+	intr_set_level(old_level);
+}
+
+/* Prints the number of runs and the run times of each interrupt
+	handler that has run, followed by the longest windows with
+	interrupts off, if they were traced. */
+void intr_print_stats(void)
+{
+	int vec, i;
+
+	for (vec = 0; vec < INTR_CNT; vec++) {
+		if (intr_cnt[vec] == 0)
+			continue;
+		printf(
+			 "Interrupt: %#04x (%s): %u runs, %" PRIu64 " cycles total (max %" PRIu64 ")\n",
+			 vec,
+			 intr_names[vec],
+			 intr_cnt[vec],
+			 intr_cycles[vec],
+			 intr_max_cycles[vec]);
+		printf("  run time (cycles):");
+		for (i = 0; i < INTR_HIST_BUCKETS; i++)
+			if (intr_hist[vec][i] != 0)
+				printf(
+					 " %lu%s:%u",
+					 i == 0 ? 0 : 1ul << (i - 1),
+					 i == INTR_HIST_BUCKETS - 1 ? "+" : "",
+					 intr_hist[vec][i]);
+		printf("\n");
+	}
+	for (i = 0; i < SOFTIRQ_CNT; i++) {
+		const struct softirq_action* s = &softirqs[i];
+		if (s->raised == 0)
+			continue;
+		printf(
+			 "Softirq: %s: %u raised, %u runs, %" PRIu64 " cycles total (max %" PRIu64 ")\n",
+			 s->name,
+			 s->raised,
+			 s->runs,
+			 s->cycles,
+			 s->max_cycles);
 	}
+	if (softirq_deferrals > 0)
+		printf("Softirq: %u hand-offs to softirqd\n", softirq_deferrals);
+
+	if (!intr_irqsoff_trace)
+		return;
+	printf("Interrupts off: %u windows traced, longest by caller:\n", irqsoff_cnt);
+	for (i = 0; i < IRQSOFF_TOP_CNT && irqsoff_top[i].caller != NULL; i++)
+		printf("  %" PRIu64 " cycles at %p\n", irqsoff_top[i].cycles, irqsoff_top[i].caller);
 }
 
 /* Handles an unexpected interrupt with interrupt frame F.  An
@@ -14,6 +14,12 @@ enum intr_level intr_get_level(void);
 enum intr_level intr_set_level(enum intr_level);
 enum intr_level intr_enable(void);
 enum intr_level intr_disable(void);
+void intr_halt(void);
+
+/* If true, record the longest windows with interrupts off.
+	Controlled by kernel command-line option "-irqsoff". */
+extern bool intr_irqsoff_trace;
+void intr_irqsoff_end(void);
 
 /* Interrupt stack frame. */
 struct intr_frame {
@@ -56,7 +62,9 @@ struct intr_frame {
 typedef void intr_handler_func(struct intr_frame*);
 
 void intr_init(void);
+void intr_init_ap(void);
 void intr_register_ext(uint8_t vec, intr_handler_func*, const char* name);
+void intr_register_local(uint8_t vec, intr_handler_func*, const char* name);
 void intr_register_int(
 	 uint8_t vec, int dpl, enum intr_level, intr_handler_func*, const char* name);
 intr_handler_func* intr_bypass_int(uint8_t vec, intr_handler_func*);
@@ -64,7 +72,27 @@ void intr_clear_int(uint8_t vec);
 bool intr_context(void);
 void intr_yield_on_return(void);
 
+/* Softirqs, or "bottom halves": the part of an external
+	interrupt's work that can wait until the handler has returned
+	and interrupts are back on.  Softirqs with lower numbers run
+	first. */
+enum softirq {
+	SOFTIRQ_TIMER,	 /* Expired timers. */
+	SOFTIRQ_BLOCK,	 /* Disk request completions. */
+	SOFTIRQ_SERIAL, /* Serial port transmission. */
+	SOFTIRQ_CNT
+};
+
+/* Function that performs a softirq.  Runs with interrupts on, but
+	like an interrupt handler it may not sleep. */
+typedef void softirq_func(void);
+
+void intr_register_softirq(enum softirq, softirq_func*, const char* name);
+void intr_raise_softirq(enum softirq);
+void intr_softirq_start(void);
+
 void intr_dump_frame(const struct intr_frame*);
 const char* intr_name(uint8_t vec);
+void intr_print_stats(void);
 
 #endif /* threads/interrupt.h */
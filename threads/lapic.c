@@ -0,0 +1,243 @@
+#include "threads/lapic.h"
+
+#include "devices/timer.h"
+#include "threads/init.h"
+#include "threads/interrupt.h"
+#include "threads/io.h"
+#include "threads/palloc.h"
+#include "threads/pte.h"
+#include "threads/synch.h"
+#include "threads/vaddr.h"
+
+#include <debug.h>
+#include <stdint.h>
+
+/* Interface to the local APIC, the interrupt controller built
+	into each CPU, which receives interrupts for the CPU, has a
+	timer of its own, and sends and receives inter-processor
+	interrupts.  Each CPU sees its own local APIC at the same
+	physical address.  See [IA32-v3a] chapter 8 "Advanced
+	Programmable Interrupt Controller (APIC)". */
+
+/* Kernel virtual address at which the registers are mapped.  It
+	is above the mapping of physical memory, which covers at most
+	64 MB. */
+#define LAPIC_VADDR ((void*) 0xfee00000)
+
+/* Register offsets. */
+#define LAPIC_ID	  0x020 /* Local APIC ID. */
+#define LAPIC_VER	  0x030 /* Version. */
+#define LAPIC_TPR	  0x080 /* Task priority. */
+#define LAPIC_EOI	  0x0b0 /* End of interrupt. */
+#define LAPIC_SVR	  0x0f0 /* Spurious interrupt vector. */
+#define LAPIC_ESR	  0x280 /* Error status. */
+#define LAPIC_ICRLO 0x300 /* Interrupt command, bits 0...31. */
+#define LAPIC_ICRHI 0x310 /* Interrupt command, bits 32...63. */
+#define LAPIC_TIMER 0x320 /* LVT timer. */
+#define LAPIC_LINT0 0x350 /* LVT local interrupt 0. */
+#define LAPIC_LINT1 0x360 /* LVT local interrupt 1. */
+#define LAPIC_ERROR 0x370 /* LVT error. */
+#define LAPIC_TICR  0x380 /* Timer initial count. */
+#define LAPIC_TCCR  0x390 /* Timer current count. */
+#define LAPIC_TDCR  0x3e0 /* Timer divide configuration. */
+
+/* Spurious interrupt vector register. */
+#define SVR_ENABLE 0x100 /* APIC software enable. */
+
+/* Interrupt command register. */
+#define ICR_FIXED	  0x00000 /* Fixed delivery. */
+#define ICR_INIT	  0x00500 /* INIT delivery. */
+#define ICR_STARTUP 0x00600 /* Start-up delivery. */
+#define ICR_DELIVS  0x01000 /* Delivery pending. */
+#define ICR_ASSERT  0x04000 /* Assert level. */
+#define ICR_LEVEL	  0x08000 /* Level triggered. */
+
+/* Local vector table entries. */
+#define LVT_EXTINT	0x00700 /* Deliver as from the 8259A PIC. */
+#define LVT_NMI		0x00400 /* Deliver as NMI. */
+#define LVT_MASKED	0x10000 /* Interrupt masked. */
+#define LVT_PERIODIC 0x20000 /* Timer: periodic, not one-shot. */
+
+/* Timer divide configuration: count at a sixteenth of the bus
+	clock. */
+#define TDCR_DIV16 0x3
+
+/* CMOS shutdown status byte and the BIOS warm reset vector, which
+	a CPU that gets INIT follows if the byte is SHUTDOWN_WARM. */
+#define CMOS_REG_SET	  0x70
+#define CMOS_REG_IO	  0x71
+#define CMOS_SHUTDOWN  0x0f
+#define SHUTDOWN_WARM  0x0a
+#define WARM_RESET_VEC 0x467
+
+/* Timer ticks to calibrate the local APIC timer over. */
+#define LAPIC_CALIBRATE_TICKS 10
+
+/* Local APIC registers, or a null pointer if not mapped. */
+static volatile uint32_t* lapic;
+
+/* Local APIC timer count per timer tick.  Initialized by
+	lapic_timer_calibrate(). */
+static uint32_t lapic_timer_count;
+
+/* Writes VALUE to local APIC register REG. */
+static void lapic_write(int reg, uint32_t value)
+{
+	lapic[reg / 4] = value;
+
+	/* Wait for the write to finish, by reading. */
+	(void) lapic[LAPIC_ID / 4];
+}
+
+/* Returns the value of local APIC register REG. */
+static uint32_t lapic_read(int reg)
+{
+	return lapic[reg / 4];
+}
+
+/* Maps the local APIC registers, which are at physical address
+	PADDR, into the kernel's address space.  Must be called
+	before any page directory is copied from init_page_dir. */
+void lapic_map(uintptr_t paddr)
+{
+	uint32_t* pd = init_page_dir;
+	uint32_t* pde = &pd[pd_no(LAPIC_VADDR)];
+	uint32_t* pt;
+
+	ASSERT(pg_ofs((void*) paddr) == 0);
+
+	if (*pde == 0)
+		*pde = pde_create(palloc_get_page(PAL_ASSERT | PAL_ZERO));
+	pt = pde_get_pt(*pde);
+
+	/* Registers must not be cached. */
+	pt[pt_no(LAPIC_VADDR)] = paddr | PTE_P | PTE_W | PTE_PCD | PTE_PWT;
+	asm volatile("movl %0, %%cr3" : : "r"(vtop(init_page_dir)) : "memory");
+	lapic = LAPIC_VADDR;
+}
+
+/* Initializes the current CPU's local APIC.  On the bootstrap
+	processor, if BSP is true, PIC interrupts keep arriving
+	through local interrupt 0 and the timer stays off.  An
+	application processor leaves PIC interrupts to the bootstrap
+	processor and runs its timer at TIMER_FREQ, for
+	thread_tick(). */
+void lapic_init(bool bsp)
+{
+	ASSERT(lapic != NULL);
+
+	lapic_write(LAPIC_SVR, SVR_ENABLE | LAPIC_SPURIOUS_VEC);
+	if (bsp) {
+		lapic_write(LAPIC_LINT0, LVT_EXTINT);
+		lapic_write(LAPIC_LINT1, LVT_NMI);
+		lapic_write(LAPIC_TIMER, LVT_MASKED | LAPIC_TIMER_VEC);
+	}
+	else {
+		lapic_write(LAPIC_LINT0, LVT_MASKED);
+		lapic_write(LAPIC_LINT1, LVT_MASKED);
+		lapic_write(LAPIC_TDCR, TDCR_DIV16);
+		lapic_write(LAPIC_TIMER, LVT_PERIODIC | LAPIC_TIMER_VEC);
+		lapic_write(LAPIC_TICR, lapic_timer_count);
+	}
+	lapic_write(LAPIC_ERROR, LVT_MASKED | LAPIC_ERROR_VEC);
+
+	/* Clear the error status, which takes back-to-back writes,
+		and any interrupt still awaiting EOI. */
+	lapic_write(LAPIC_ESR, 0);
+	lapic_write(LAPIC_ESR, 0);
+	lapic_write(LAPIC_EOI, 0);
+
+	/* Accept interrupts of every priority. */
+	lapic_write(LAPIC_TPR, 0);
+}
+
+/* Returns the local APIC ID of the current CPU. */
+uint8_t lapic_id(void)
+{
+	ASSERT(lapic != NULL);
+	return lapic_read(LAPIC_ID) >> 24;
+}
+
+/* Signals the end of the interrupt being handled to the local
+	APIC, which must not be the spurious interrupt. */
+void lapic_eoi(void)
+{
+	lapic_write(LAPIC_EOI, 0);
+}
+
+/* Sends interrupt command LO to the CPU with local APIC ID
+	APIC_ID and waits for it to be delivered. */
+static void lapic_icr(uint8_t apic_id, uint32_t lo)
+{
+	lapic_write(LAPIC_ICRHI, (uint32_t) apic_id << 24);
+	lapic_write(LAPIC_ICRLO, lo);
+	while (lapic_read(LAPIC_ICRLO) & ICR_DELIVS) asm volatile("pause");
+}
+
+/* Sends interrupt VEC to the CPU with local APIC ID APIC_ID. */
+void lapic_send_ipi(uint8_t apic_id, uint8_t vec)
+{
+	ASSERT(vec >= LAPIC_VEC_MIN);
+	lapic_icr(apic_id, ICR_FIXED | vec);
+}
+
+/* Starts the application processor with local APIC ID APIC_ID
+	running real-mode code at physical address PADDR, which must
+	be page-aligned and below 1 MB, with the INIT-SIPI-SIPI
+	sequence of [MP] appendix B.4.  Must be called with interrupts
+	on, after timer_calibrate(). */
+void lapic_start_ap(uint8_t apic_id, uintptr_t paddr)
+{
+	uint16_t* warm_reset = ptov(WARM_RESET_VEC);
+	int i;
+
+	ASSERT(pg_ofs((void*) paddr) == 0 && paddr < 0x100000);
+
+	/* Some BIOSes send a CPU that gets INIT through the warm reset
+		vector instead of halting it.  Point the vector at PADDR. */
+	outb(CMOS_REG_SET, CMOS_SHUTDOWN);
+	outb(CMOS_REG_IO, SHUTDOWN_WARM);
+	warm_reset[0] = 0;
+	warm_reset[1] = paddr >> 4;
+
+	/* INIT, asserted and then deasserted, resets the CPU, which
+		then waits for a start-up IPI. */
+	lapic_icr(apic_id, ICR_INIT | ICR_LEVEL | ICR_ASSERT);
+	timer_udelay(200);
+	lapic_icr(apic_id, ICR_INIT | ICR_LEVEL);
+	timer_mdelay(10);
+
+	/* The start-up IPI starts the CPU at the page it names.  It
+		is sent twice, because it may be missed. */
+	for (i = 0; i < 2; i++) {
+		lapic_icr(apic_id, ICR_STARTUP | (paddr >> 12));
+		timer_udelay(200);
+	}
+
+	outb(CMOS_REG_SET, CMOS_SHUTDOWN);
+	outb(CMOS_REG_IO, 0);
+}
+
+/* Measures how far the local APIC timer counts in a timer tick,
+	so that application processors can tick at TIMER_FREQ too.
+	Every local APIC timer counts at the same bus clock rate.
+	Must be called on the bootstrap processor, with interrupts on,
+	after lapic_init(). */
+void lapic_timer_calibrate(void)
+{
+	int64_t start;
+
+	ASSERT(intr_get_level() == INTR_ON);
+
+	lapic_write(LAPIC_TDCR, TDCR_DIV16);
+	lapic_write(LAPIC_TIMER, LVT_MASKED | LAPIC_TIMER_VEC);
+
+	/* Count from just after one tick to just after another. */
+	start = timer_ticks();
+	while (timer_ticks() == start) barrier();
+	lapic_write(LAPIC_TICR, UINT32_MAX);
+	start = timer_ticks();
+	while (timer_ticks() < start + LAPIC_CALIBRATE_TICKS) barrier();
+	lapic_timer_count = (UINT32_MAX - lapic_read(LAPIC_TCCR)) / LAPIC_CALIBRATE_TICKS;
+	lapic_write(LAPIC_TICR, 0);
+}
@@ -0,0 +1,27 @@
+#ifndef THREADS_LAPIC_H
+#define THREADS_LAPIC_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Physical address of the local APIC registers, unless the MP or
+	ACPI tables say otherwise. */
+#define LAPIC_DEFAULT_BASE 0xfee00000
+
+/* Interrupt vectors of the local APIC.  Vectors from LAPIC_VEC_MIN
+	up are reserved for it. */
+#define LAPIC_VEC_MIN		  0xf0
+#define LAPIC_TIMER_VEC		  0xf0 /* Local APIC timer. */
+#define LAPIC_RESCHEDULE_VEC 0xf1 /* Inter-processor reschedule. */
+#define LAPIC_ERROR_VEC		  0xfe /* Local APIC error (masked). */
+#define LAPIC_SPURIOUS_VEC	  0xff /* Spurious interrupt, no EOI. */
+
+void lapic_map(uintptr_t paddr);
+void lapic_init(bool bsp);
+uint8_t lapic_id(void);
+void lapic_eoi(void);
+void lapic_send_ipi(uint8_t apic_id, uint8_t vec);
+void lapic_start_ap(uint8_t apic_id, uintptr_t paddr);
+void lapic_timer_calibrate(void);
+
+#endif /* threads/lapic.h */
@@ -0,0 +1,163 @@
+#include "threads/profile.h"
+
+#include "threads/interrupt.h"
+#include "threads/thread.h"
+#include "threads/vaddr.h"
+#ifdef USERPROG
+#include "userprog/pagedir.h"
+#endif
+
+#include <debug.h>
+#include <hash.h>
+#include <inttypes.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+
+/* Statistical sampling profiler.
+
+	Every profile_interval timer ticks, the timer interrupt
+	handler records where the interrupted code was: its eip
+	followed by the return addresses found by following the
+	chain of saved frame pointers, innermost first, up to
+	PROFILE_DEPTH addresses in all.  Identical stacks are counted
+	in a fixed-size hash table, so taking a sample never
+	allocates memory.  A stack that finds no free slot within
+	PROFILE_PROBES probes is counted as dropped.
+
+	profile_print() writes one line per distinct stack, in the
+	form
+		PROF <count> kernel <eip> <return address>...
+	or, for user code,
+		PROF <count> user:<thread name> <eip> <return address>...
+	with the addresses in hex.  utils/pintos-prof turns these
+	lines into symbolic stacks folded for flame graphs.
+
+	Backtraces need frame pointers, which GCC keeps unless
+	optimization is turned up and -fomit-frame-pointer is in
+	effect. */
+#define PROFILE_DEPTH 8		/* Addresses per sample. */
+#define PROFILE_SLOTS 1024 /* Hash table size, a power of 2. */
+#define PROFILE_PROBES 16	/* Slots to try before dropping a sample. */
+
+/* A distinct stack and the number of samples of it.  The members
+	before `count' form the key. */
+struct profile_entry {
+	bool user;							 /* Interrupted in user mode? */
+	uint8_t depth;						 /* Number of addresses in PCS. */
+	char name[16];						 /* Thread name, for user samples. */
+	uint32_t pcs[PROFILE_DEPTH]; /* eip, then return addresses. */
+	unsigned count;					 /* Samples, 0 if the slot is free. */
+};
+#define PROFILE_KEY_SIZE offsetof(struct profile_entry, count)
+
+unsigned profile_interval;
+
+static struct profile_entry profile_table[PROFILE_SLOTS];
+static unsigned profile_samples; /* Samples taken. */
+static unsigned profile_dropped; /* Samples that found no slot. */
+
+static int walk_kernel(uint32_t ebp, uint32_t pcs[], int cnt);
+static int walk_user(uint32_t ebp, uint32_t pcs[], int cnt);
+
+/* Records a sample of the code interrupted with frame F.  Called
+	by the timer interrupt handler. */
+void profile_sample(const struct intr_frame* f)
+{
+	struct profile_entry key;
+	unsigned hash;
+	int i;
+
+	ASSERT(intr_get_level() == INTR_OFF);
+
+	/* Zeroing the whole key, padding included, lets keys be
+		compared with memcmp(). */
+	memset(&key, 0, sizeof key);
+	key.user = (f->cs & 3) == 3;
+	key.pcs[0] = (uint32_t) f->eip;
+	if (key.user) {
+		key.depth = 1 + walk_user(f->ebp, key.pcs + 1, PROFILE_DEPTH - 1);
+		strlcpy(key.name, thread_name(), sizeof key.name);
+	}
+	else
+		key.depth = 1 + walk_kernel(f->ebp, key.pcs + 1, PROFILE_DEPTH - 1);
+
+	profile_samples++;
+	hash = hash_bytes(&key, PROFILE_KEY_SIZE);
+	for (i = 0; i < PROFILE_PROBES; i++) {
+		struct profile_entry* e = &profile_table[(hash + i) % PROFILE_SLOTS];
+		if (e->count == 0) {
+			memcpy(e, &key, PROFILE_KEY_SIZE);
+			e->count = 1;
+			return;
+		}
+		if (!memcmp(e, &key, PROFILE_KEY_SIZE)) {
+			e->count++;
+			return;
+		}
+	}
+	profile_dropped++;
+}
+
+/* Prints the samples taken, if the profiler is enabled, in the
+	format described at the top of this file. */
+void profile_print(void)
+{
+	int i, j;
+
+	if (profile_interval == 0)
+		return;
+
+	printf("Profile: %u samples, %u dropped\n", profile_samples, profile_dropped);
+	for (i = 0; i < PROFILE_SLOTS; i++) {
+		const struct profile_entry* e = &profile_table[i];
+		if (e->count == 0)
+			continue;
+		printf("PROF %u %s%s", e->count, e->user ? "user:" : "kernel", e->user ? e->name : "");
+		for (j = 0; j < e->depth; j++) printf(" %08" PRIx32, e->pcs[j]);
+		printf("\n");
+	}
+}
+
+/* Follows the chain of frame pointers that starts at EBP on the
+	running thread's kernel stack, storing up to CNT return
+	addresses into PCS.  Returns the number stored.  Stops at
+	any frame pointer that does not point farther up the same
+	stack page, so a corrupt chain cannot lead astray. */
+static int walk_kernel(uint32_t ebp, uint32_t pcs[], int cnt)
+{
+	uint32_t page = (uint32_t) pg_round_down(&ebp);
+	int n = 0;
+
+	while (n < cnt && ebp % 4 == 0 && ebp > page && ebp <= page + PGSIZE - 8) {
+		const uint32_t* frame = (const uint32_t*) ebp;
+		pcs[n++] = frame[1];
+		if (frame[0] <= ebp)
+			break;
+		ebp = frame[0];
+	}
+	return n;
+}
+
+/* Follows the chain of frame pointers that starts at EBP on the
+	running process's user stack, storing up to CNT return
+	addresses into PCS.  Returns the number stored.  Reads only
+	mapped user memory, so it cannot fault. */
+static int walk_user(uint32_t ebp UNUSED, uint32_t pcs[] UNUSED, int cnt UNUSED)
+{
+	int n = 0;
+#ifdef USERPROG
+	uint32_t* pd = thread_current()->pagedir;
+
+	while (n < cnt && pd != NULL && ebp % 4 == 0 && is_user_vaddr((void*) (ebp + 7))
+			 && pagedir_get_page(pd, (void*) ebp) != NULL
+			 && pagedir_get_page(pd, (void*) (ebp + 4)) != NULL) {
+		const uint32_t* frame = (const uint32_t*) ebp;
+		pcs[n++] = frame[1];
+		if (frame[0] <= ebp)
+			break;
+		ebp = frame[0];
+	}
+#endif
+	return n;
+}
@@ -66,6 +66,8 @@ static inline uintptr_t pd_no(const void* va)
 #define PTE_P		0x1		  /* 1=present, 0=not present. */
 #define PTE_W		0x2		  /* 1=read/write, 0=read-only. */
 #define PTE_U		0x4		  /* 1=user/kernel, 0=kernel only. */
+#define PTE_PWT	0x8		  /* 1=write-through, 0=write-back. */
+#define PTE_PCD	0x10		  /* 1=cache disabled, 0=cache enabled. */
 #define PTE_A		0x20		  /* 1=accessed, 0=not acccessed. */
 #define PTE_D		0x40		  /* 1=dirty, 0=not dirty (PTEs only). */
 
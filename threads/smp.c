@@ -0,0 +1,422 @@
+#include "threads/smp.h"
+
+#include "devices/timer.h"
+#include "threads/cpu.h"
+#include "threads/init.h"
+#include "threads/interrupt.h"
+#include "threads/lapic.h"
+#include "threads/loader.h"
+#include "threads/pte.h"
+#include "threads/thread.h"
+#include "threads/vaddr.h"
+#ifdef USERPROG
+#include "userprog/gdt.h"
+#include "userprog/tss.h"
+#endif
+
+#include <debug.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+/* Symmetric multiprocessing support.
+
+	smp_init() finds the CPUs, from the BIOS's MultiProcessor
+	table [MP] or, failing that, the ACPI MADT [ACPI], and
+	smp_start() starts each application processor (AP) through
+	the trampoline in ap-start.S.  An AP then runs ap_main(),
+	which sets up its interrupts, GDT, and TSS, and goes on to
+	schedule threads from its own run queue, as the bootstrap
+	processor (BSP) does.
+
+	All CPUs share the kernel under the big kernel lock, which a
+	CPU holds while its interrupts are off; see interrupt.c. */
+
+/* BIOS data area words giving the segment of the extended BIOS
+	data area and the kB of base memory. */
+#define BDA_EBDA	  0x40e
+#define BDA_BASE_KB 0x413
+
+/* Start and end of the BIOS ROM area that is searched last. */
+#define BIOS_ROM_START 0xe0000
+#define BIOS_ROM_END	  0x100000
+
+/* How long to wait for an AP to come up, in milliseconds. */
+#define AP_TIMEOUT_MS 100
+
+/* [MP] 4.1 "MP Floating Pointer Structure". */
+struct mp_float {
+	char signature[4]; /* "_MP_". */
+	uint32_t config;	 /* Physical address of struct mp_config. */
+	uint8_t length;	 /* In 16-byte units. */
+	uint8_t revision;
+	uint8_t checksum;
+	uint8_t feature1; /* Nonzero for a default configuration. */
+	uint8_t feature2;
+	uint8_t reserved[3];
+} __attribute__((packed));
+
+/* [MP] 4.2 "MP Configuration Table Header", followed by the
+	entries. */
+struct mp_config {
+	char signature[4]; /* "PCMP". */
+	uint16_t length;	 /* Of the header and the entries. */
+	uint8_t revision;
+	uint8_t checksum;
+	char oem_id[8];
+	char product_id[12];
+	uint32_t oem_table;
+	uint16_t oem_table_size;
+	uint16_t entry_cnt;
+	uint32_t lapic_addr;
+	uint16_t ext_length;
+	uint8_t ext_checksum;
+	uint8_t reserved;
+} __attribute__((packed));
+
+/* [MP] 4.3.1 "Processor Entries".  Entries of other types are 8
+	bytes long. */
+#define MP_PROCESSOR		 0
+#define MP_PROC_ENABLED 0x01
+struct mp_processor {
+	uint8_t type; /* MP_PROCESSOR. */
+	uint8_t apic_id;
+	uint8_t apic_version;
+	uint8_t flags;
+	uint32_t signature;
+	uint32_t features;
+	uint32_t reserved[2];
+} __attribute__((packed));
+
+/* [ACPI] 5.2.5 "Root System Description Pointer". */
+struct acpi_rsdp {
+	char signature[8]; /* "RSD PTR ". */
+	uint8_t checksum;
+	char oem_id[6];
+	uint8_t revision;
+	uint32_t rsdt; /* Physical address of the RSDT. */
+} __attribute__((packed));
+
+/* [ACPI] 5.2.6 "System Description Table Header", which starts
+	the RSDT, whose body is the physical addresses of the other
+	tables, and the MADT. */
+struct acpi_header {
+	char signature[4];
+	uint32_t length; /* Of the header and the body. */
+	uint8_t revision;
+	uint8_t checksum;
+	char oem_id[6];
+	char oem_table_id[8];
+	uint32_t oem_revision;
+	uint32_t creator_id;
+	uint32_t creator_revision;
+} __attribute__((packed));
+
+/* [ACPI] 5.2.12 "Multiple APIC Description Table", followed by
+	entries that start with a type and a length. */
+struct acpi_madt {
+	struct acpi_header header; /* Signature "APIC". */
+	uint32_t lapic_addr;
+	uint32_t flags;
+} __attribute__((packed));
+
+/* [ACPI] 5.2.12.2 "Processor Local APIC Structure". */
+#define MADT_LAPIC			0
+#define MADT_LAPIC_ENABLED 0x01
+struct madt_lapic {
+	uint8_t type; /* MADT_LAPIC. */
+	uint8_t length;
+	uint8_t acpi_id;
+	uint8_t apic_id;
+	uint32_t flags;
+} __attribute__((packed));
+
+/* Maximum number of CPUs to use.  Just the bootstrap processor
+	unless asked for more, because starting the others has not
+	been tested on real machines or emulators yet. */
+int smp_cpu_limit = 1;
+
+/* The trampoline in ap-start.S, and the place in it for the
+	page directory's physical address. */
+extern char ap_trampoline[], ap_trampoline_end[], ap_cr3[];
+
+/* Stack for the AP being started, used by ap-start.S. */
+void* ap_boot_stack;
+
+void ap_main(void) NO_RETURN;
+
+/* Set by the AP being started once it is up. */
+static volatile bool ap_alive;
+
+/* Set by smp_start() once it is done with every AP. */
+static volatile bool smp_go;
+
+static int mp_find(uint8_t apic_ids[], uintptr_t* lapic_paddr);
+static int acpi_find(uint8_t apic_ids[], uintptr_t* lapic_paddr);
+static void* bios_search(const char* signature, size_t size);
+static void* phys_table(uintptr_t paddr, size_t size);
+static uint8_t checksum(const void*, size_t);
+static void lapic_timer_interrupt(struct intr_frame*);
+static void reschedule_interrupt(struct intr_frame*);
+
+/* Finds the CPUs in the system and fills in cpus[] and cpu_cnt
+	with up to smp_cpu_limit of them, the BSP first.  Does nothing
+	if smp_cpu_limit is 1, leaving just the BSP.  Finding more
+	than one CPU also sets up the BSP's local APIC.  Must be
+	called after paging_init(), with interrupts off. */
+void smp_init(void)
+{
+	uint8_t apic_ids[UINT8_MAX + 1];
+	uintptr_t lapic_paddr;
+	uint8_t bsp_id;
+	int cnt;
+	int i;
+
+	ASSERT(intr_get_level() == INTR_OFF);
+
+	if (smp_cpu_limit < 2)
+		return;
+	cnt = mp_find(apic_ids, &lapic_paddr);
+	if (cnt == 0)
+		cnt = acpi_find(apic_ids, &lapic_paddr);
+	if (cnt < 2)
+		return;
+
+	lapic_map(lapic_paddr);
+	bsp_id = lapic_id();
+	cpus[0].apic_id = bsp_id;
+	for (i = 0; i < cnt; i++)
+		if (apic_ids[i] != bsp_id && cpu_cnt < smp_cpu_limit && cpu_cnt < CPU_MAX) {
+			struct cpu* c = &cpus[cpu_cnt];
+
+			c->id = cpu_cnt++;
+			c->apic_id = apic_ids[i];
+		}
+	lapic_init(true);
+	printf("SMP: %d CPUs found, using %d.\n", cnt, cpu_cnt);
+}
+
+/* Starts the APs that smp_init() found, giving up on the rest at
+	the first that does not come up.  Must be called with
+	interrupts on, after timer_calibrate(). */
+void smp_start(void)
+{
+	uint8_t* trampoline = ptov(AP_TRAMPOLINE);
+	uint32_t* pd = init_page_dir;
+	int i;
+
+	ASSERT(intr_get_level() == INTR_ON);
+
+	if (cpu_cnt == 1)
+		return;
+
+	intr_register_local(LAPIC_TIMER_VEC, lapic_timer_interrupt, "Local APIC Timer");
+	intr_register_local(LAPIC_RESCHEDULE_VEC, reschedule_interrupt, "Reschedule IPI");
+	lapic_timer_calibrate();
+
+	/* The trampoline turns on paging while it is still running in
+		low memory, so map low memory to itself until the APs are
+		past it. */
+	memcpy(trampoline, ap_trampoline, ap_trampoline_end - ap_trampoline);
+	*(uint32_t*) (trampoline + (ap_cr3 - ap_trampoline)) = vtop(init_page_dir);
+	pd[0] = pd[pd_no(PHYS_BASE)];
+
+	for (i = 1; i < cpu_cnt; i++) {
+		struct cpu* c = &cpus[i];
+		int ms;
+
+		ap_boot_stack = thread_prepare_cpu(c);
+		ap_alive = false;
+		lapic_start_ap(c->apic_id, AP_TRAMPOLINE);
+		for (ms = 0; ms < AP_TIMEOUT_MS && !ap_alive; ms++) timer_mdelay(1);
+		if (!ap_alive) {
+			printf("SMP: cpu %d (APIC ID %u) did not start.\n", i, c->apic_id);
+			break;
+		}
+	}
+	cpu_cnt = i;
+
+	pd[0] = 0;
+	asm volatile("movl %0, %%cr3" : : "r"(vtop(init_page_dir)) : "memory");
+	smp_go = true;
+	printf("SMP: %d CPUs started.\n", cpu_cnt);
+}
+
+/* Makes CPU C, which is not the current CPU, reconsider which
+	thread to run. */
+void smp_reschedule(struct cpu* c)
+{
+	ASSERT(c != cpu_current());
+
+	lapic_send_ipi(c->apic_id, LAPIC_RESCHEDULE_VEC);
+}
+
+/* An AP's C entry point, called by ap-start.S on the stack of
+	the idle thread that thread_prepare_cpu() set up for it. */
+void ap_main(void)
+{
+	struct cpu* c = cpu_current();
+
+	lapic_init(false);
+	ap_alive = true;
+
+	/* Wait until smp_start() is done, so that it has removed the
+		mapping of low memory and settled cpu_cnt. */
+	while (!smp_go) asm volatile("pause" : : : "memory");
+	asm volatile("movl %0, %%cr3" : : "r"(vtop(init_page_dir)) : "memory");
+	if (c->id >= cpu_cnt) {
+		/* smp_start() gave up on us. */
+		for (;;) asm volatile("cli; hlt");
+	}
+
+	intr_init_ap();
+#ifdef USERPROG
+	tss_init();
+	gdt_init();
+#endif
+	thread_start_ap();
+}
+
+/* Stores the APIC IDs of the enabled CPUs listed in the [MP]
+	configuration table into APIC_IDS and the physical address of
+	the local APICs into *LAPIC_PADDR, and returns the number of
+	CPUs.  Returns 0 if there is no usable table. */
+static int mp_find(uint8_t apic_ids[], uintptr_t* lapic_paddr)
+{
+	struct mp_float* mp = bios_search("_MP_", sizeof *mp);
+	struct mp_config* conf;
+	uint8_t *p, *end;
+	int cnt = 0;
+
+	/* A default configuration, with no table, has at most two
+		CPUs, and is not worth supporting. */
+	if (mp == NULL || mp->config == 0 || mp->feature1 != 0)
+		return 0;
+	conf = phys_table(mp->config, sizeof *conf);
+	if (conf == NULL || memcmp(conf->signature, "PCMP", 4) != 0
+		 || phys_table(mp->config, conf->length) == NULL || checksum(conf, conf->length) != 0)
+		return 0;
+
+	*lapic_paddr = conf->lapic_addr;
+	p = (uint8_t*) (conf + 1);
+	end = (uint8_t*) conf + conf->length;
+	while (p < end && cnt <= UINT8_MAX)
+		if (*p == MP_PROCESSOR) {
+			struct mp_processor* proc = (struct mp_processor*) p;
+
+			if (proc->flags & MP_PROC_ENABLED)
+				apic_ids[cnt++] = proc->apic_id;
+			p += sizeof *proc;
+		}
+		else
+			p += 8;
+	return cnt;
+}
+
+/* Does what mp_find() does, from the ACPI MADT. */
+static int acpi_find(uint8_t apic_ids[], uintptr_t* lapic_paddr)
+{
+	struct acpi_rsdp* rsdp = bios_search("RSD PTR ", sizeof *rsdp);
+	struct acpi_header* rsdt;
+	uint32_t* tables;
+	size_t table_cnt;
+	size_t i;
+
+	if (rsdp == NULL)
+		return 0;
+	rsdt = phys_table(rsdp->rsdt, sizeof *rsdt);
+	if (rsdt == NULL || memcmp(rsdt->signature, "RSDT", 4) != 0
+		 || phys_table(rsdp->rsdt, rsdt->length) == NULL)
+		return 0;
+
+	tables = (uint32_t*) (rsdt + 1);
+	table_cnt = (rsdt->length - sizeof *rsdt) / sizeof *tables;
+	for (i = 0; i < table_cnt; i++) {
+		struct acpi_madt* madt = phys_table(tables[i], sizeof *madt);
+		uint8_t *p, *end;
+		int cnt = 0;
+
+		if (madt == NULL || memcmp(madt->header.signature, "APIC", 4) != 0
+			 || phys_table(tables[i], madt->header.length) == NULL
+			 || checksum(madt, madt->header.length) != 0)
+			continue;
+
+		*lapic_paddr = madt->lapic_addr;
+		p = (uint8_t*) (madt + 1);
+		end = (uint8_t*) madt + madt->header.length;
+		while (p + 2 <= end && p[1] >= 2 && cnt <= UINT8_MAX) {
+			struct madt_lapic* l = (struct madt_lapic*) p;
+
+			if (l->type == MADT_LAPIC && l->flags & MADT_LAPIC_ENABLED)
+				apic_ids[cnt++] = l->apic_id;
+			p += l->length;
+		}
+		return cnt;
+	}
+	return 0;
+}
+
+/* Searches for a structure of SIZE bytes that starts with
+	SIGNATURE on a 16-byte boundary and sums to 0, where the BIOS
+	puts such structures: the first kB of the extended BIOS data
+	area, the last kB of base memory, and the BIOS ROM.  Returns
+	the structure, or a null pointer if there is none. */
+static void* bios_search(const char* signature, size_t size)
+{
+	uint16_t* ebda_seg = ptov(BDA_EBDA);
+	uint16_t* base_kb = ptov(BDA_BASE_KB);
+	uintptr_t ebda = (uintptr_t) *ebda_seg << 4;
+	uintptr_t base_end = (uintptr_t) *base_kb * 1024;
+	uintptr_t starts[3] = {ebda, base_end - 1024, BIOS_ROM_START};
+	uintptr_t ends[3] = {ebda + 1024, base_end, BIOS_ROM_END};
+	size_t sig_len = strlen(signature);
+	int i;
+
+	for (i = 0; i < 3; i++) {
+		uintptr_t paddr;
+
+		if (starts[i] == 0 || starts[i] >= ends[i] || ends[i] > BIOS_ROM_END)
+			continue;
+		for (paddr = starts[i]; paddr + size <= ends[i]; paddr += 16) {
+			uint8_t* p = ptov(paddr);
+
+			if (memcmp(p, signature, sig_len) == 0 && checksum(p, size) == 0)
+				return p;
+		}
+	}
+	return NULL;
+}
+
+/* Returns the kernel virtual address of the SIZE bytes at
+	physical address PADDR, or a null pointer if they are not all
+	in the RAM that the kernel maps. */
+static void* phys_table(uintptr_t paddr, size_t size)
+{
+	uintptr_t limit = (uintptr_t) init_ram_pages * PGSIZE;
+
+	if (paddr >= limit || size > limit - paddr)
+		return NULL;
+	return ptov(paddr);
+}
+
+/* Returns the sum of the SIZE bytes at P, modulo 256. */
+static uint8_t checksum(const void* p_, size_t size)
+{
+	const uint8_t* p = p_;
+	uint8_t sum = 0;
+
+	while (size-- > 0) sum += *p++;
+	return sum;
+}
+
+/* Local APIC timer interrupt handler, on APs. */
+static void lapic_timer_interrupt(struct intr_frame* args UNUSED)
+{
+	thread_tick();
+}
+
+/* Reschedule IPI handler, sent by smp_reschedule(). */
+static void reschedule_interrupt(struct intr_frame* args UNUSED)
+{
+	thread_preempt();
+}
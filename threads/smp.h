@@ -0,0 +1,20 @@
+#ifndef THREADS_SMP_H
+#define THREADS_SMP_H
+
+/* Physical address that application processors start at, in
+	real mode.  Must be page-aligned, below 1 MB, and unused. */
+#define AP_TRAMPOLINE 0x8000
+
+#ifndef __ASSEMBLER__
+struct cpu;
+
+/* Maximum number of CPUs to use, 1 by default.  Controlled by
+	kernel command-line option "-cpus". */
+extern int smp_cpu_limit;
+
+void smp_init(void);
+void smp_start(void);
+void smp_reschedule(struct cpu*);
+#endif
+
+#endif /* threads/smp.h */
@@ -0,0 +1,84 @@
+#ifndef THREADS_SPINLOCK_H
+#define THREADS_SPINLOCK_H
+
+#include "threads/interrupt.h"
+
+#include <debug.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+/* A spinlock, for mutual exclusion between CPUs over short
+	critical sections.
+
+	A thread must not sleep while it holds a spinlock.  Acquiring a
+	spinlock with spin_lock() also disables interrupts on the local
+	CPU, because an interrupt handler that tried to acquire a
+	spinlock held by the thread it interrupted would spin forever.
+	Disabling interrupts also takes the big kernel lock (see
+	interrupt.c), so for now such locks are never found held by
+	another CPU; they mark the data that will need them once the
+	big kernel lock is broken up.
+
+	spin_acquire() and spin_release() leave the interrupt level
+	alone.  They are for the big kernel lock itself and other code
+	that manages interrupts on its own. */
+struct spinlock {
+	volatile uint32_t locked; /* Nonzero while held. */
+	const char* name;			  /* Name, for debugging. */
+};
+
+/* Initializes LOCK, named NAME, as not held. */
+static inline void spinlock_init(struct spinlock* lock, const char* name)
+{
+	lock->locked = 0;
+	lock->name = name;
+}
+
+/* Acquires LOCK, spinning until it is available. */
+static inline void spin_acquire(struct spinlock* lock)
+{
+	uint32_t locked = 1;
+
+	/* `xchg' with a memory operand is implicitly locked. */
+	for (;;) {
+		asm volatile("xchgl %0, %1" : "+r"(locked), "+m"(lock->locked) : : "memory");
+		if (locked == 0)
+			break;
+		while (lock->locked != 0) asm volatile("pause");
+		locked = 1;
+	}
+}
+
+/* Releases LOCK, which the current CPU must hold. */
+static inline void spin_release(struct spinlock* lock)
+{
+	ASSERT(lock->locked != 0);
+
+	asm volatile("movl $0, %0" : "=m"(lock->locked) : : "memory");
+}
+
+/* Disables interrupts and acquires LOCK, spinning until it is
+	available.  Returns the previous interrupt level, to pass to
+	spin_unlock(). */
+static inline enum intr_level spin_lock(struct spinlock* lock)
+{
+	enum intr_level old_level = intr_disable();
+	spin_acquire(lock);
+	return old_level;
+}
+
+/* Releases LOCK, which the current CPU must hold, and restores
+	interrupts to OLD_LEVEL. */
+static inline void spin_unlock(struct spinlock* lock, enum intr_level old_level)
+{
+	spin_release(lock);
+	intr_set_level(old_level);
+}
+
+/* Returns true if LOCK is held by some CPU. */
+static inline bool spin_is_locked(const struct spinlock* lock)
+{
+	return lock->locked != 0;
+}
+
+#endif /* threads/spinlock.h */
@@ -28,11 +28,26 @@
 
 #include "threads/synch.h"
 
+#include "devices/timer.h"
 #include "threads/interrupt.h"
 #include "threads/thread.h"
 
 #include <stdio.h>
 #include <string.h>
+#ifdef LOCK_PROFILE
+#include <inttypes.h>
+
+/* Lock contention profiles, one per lock name.  Once the table
+	is full, locks with new names share its last entry. */
+#define LOCK_SITE_CNT 64
+#define LOCK_REPORT_CNT 10 /* Number of sites printed at power off. */
+static struct lock_site lock_sites[LOCK_SITE_CNT];
+static size_t lock_site_cnt;
+
+static struct lock_site* lock_site_lookup(const char* name);
+static void lock_profile_acquired(struct lock*, int64_t wait_start);
+static void lock_profile_released(struct lock*);
+#endif
 
 /* Initializes semaphore SEMA to VALUE.  A semaphore is a
 	nonnegative integer along with two atomic operators for
@@ -98,8 +113,85 @@ bool sema_try_down(struct semaphore* sema)
 	return success;
 }
 
+/* A thread waiting in sema_down_timeout(). */
+struct sema_timeout {
+	struct semaphore* sema; /* Semaphore being waited on. */
+	struct thread* thread;	 /* Waiting thread. */
+	bool expired;				 /* Has the timeout passed? */
+};
+
+/* Timer function for sema_down_timeout().  Wakes the waiting
+	thread unless sema_up() already has. */
+static void sema_timeout_expire(struct timer* timer UNUSED, void* st_)
+{
+	struct sema_timeout* st = st_;
+	struct list_elem* e;
+
+	st->expired = true;
+	for (e = list_begin(&st->sema->waiters); e != list_end(&st->sema->waiters); e = list_next(e))
+		if (e == &st->thread->elem) {
+			list_remove(e);
+			thread_unblock(st->thread);
+			break;
+		}
+}
+
+/* Like sema_down(), but gives up once TICKS timer ticks have
+	passed.  Returns true if SEMA was decremented, false if the
+	wait timed out.  If TICKS is zero or negative, does not wait
+	at all, like sema_try_down().
+
+	This function may sleep, so it must not be called within an
+	interrupt handler. */
+bool sema_down_timeout(struct semaphore* sema, int64_t ticks)
+{
+	struct sema_timeout st;
+	struct timer timer;
+	enum intr_level old_level;
+	bool success;
+
+	ASSERT(sema != NULL);
+	ASSERT(!intr_context());
+
+	if (ticks <= 0)
+		return sema_try_down(sema);
+
+	st.sema = sema;
+	st.thread = thread_current();
+	st.expired = false;
+	timer_setup(&timer, sema_timeout_expire, &st);
+
+	old_level = intr_disable();
+	timer_add(&timer, timer_ticks() + ticks);
+	while (sema->value == 0 && !st.expired) {
+		list_push_back(&sema->waiters, &thread_current()->elem);
+		thread_block();
+	}
+	success = sema->value > 0;
+	if (success)
+		sema->value--;
+	timer_cancel(&timer);
+	intr_set_level(old_level);
+
+	return success;
+}
+
+/* Returns true if thread A has lower priority than thread B,
+	given their `elem' members. */
+static bool thread_priority_less(
+	 const struct list_elem* a_, const struct list_elem* b_, void* aux UNUSED)
+{
+	const struct thread* a = list_entry(a_, struct thread, elem);
+	const struct thread* b = list_entry(b_, struct thread, elem);
+
+	return a->priority < b->priority;
+}
+
 /* Up or "V" operation on a semaphore.  Increments SEMA's value
-	and wakes up one thread of those waiting for SEMA, if any.
+	and wakes up the highest-priority thread of those waiting for
+	SEMA, if any.  Waiters of equal priority are woken in FIFO
+	order.  If the woken thread has a higher priority than the
+	caller, the caller yields.
 
 	This function may be called from an interrupt handler. */
 void sema_up(struct semaphore* sema)
@@ -109,10 +201,19 @@ void sema_up(struct semaphore* sema)
 	ASSERT(sema != NULL);
 
 	old_level = intr_disable();
-	if (!list_empty(&sema->waiters))
-		thread_unblock(list_entry(list_pop_front(&sema->waiters), struct thread, elem));
+	if (!list_empty(&sema->waiters)) {
+		/* Priorities may change through donation while threads
+			wait, so pick the maximum now rather than keeping the
+			list sorted. */
+		struct list_elem* e = list_max(&sema->waiters, thread_priority_less, NULL);
+		list_remove(e);
+		thread_unblock(list_entry(e, struct thread, elem));
+	}
 	sema->value++;
 	intr_set_level(old_level);
+
+	if (old_level == INTR_ON)
+		thread_preempt();
 }
 
 static void sema_test_helper(void* sema_);
@@ -162,31 +263,73 @@ static void sema_test_helper(void* sema_)
 	another one "up" it, but with a lock the same thread must both
 	acquire and release it.  When these restrictions prove
 	onerous, it's a good sign that a semaphore should be used,
-	instead of a lock. */
+	instead of a lock.
+
+	Contention on LOCK is profiled along with every other lock
+	initialized this way; see lock_init_named(). */
 void lock_init(struct lock* lock)
+{
+	lock_init_named(lock, "(unnamed)");
+}
+
+/* Initializes LOCK as lock_init() does.  NAME identifies the
+	lock, or the kind of lock, in contention profiles.  Locks
+	initialized with equal names share a profile.  NAME must
+	remain valid as long as the kernel runs. */
+void lock_init_named(struct lock* lock, const char* name UNUSED)
 {
 	ASSERT(lock != NULL);
+	ASSERT(name != NULL);
 
 	lock->holder = NULL;
 	sema_init(&lock->semaphore, 1);
+#ifdef LOCK_PROFILE
+	lock->site = lock_site_lookup(name);
+#endif
 }
 
 /* Acquires LOCK, sleeping until it becomes available if
 	necessary.  The lock must not already be held by the current
 	thread.
 
+	While we wait, our priority is donated to the lock's holder
+	and, transitively, to whatever that holder is waiting on (see
+	thread_donate_priority()).  Donation is not used by the
+	multi-level feedback queue scheduler.
+
 	This function may sleep, so it must not be called within an
 	interrupt handler.  This function may be called with
 	interrupts disabled, but interrupts will be turned back on if
 	we need to sleep. */
 void lock_acquire(struct lock* lock)
 {
+	struct thread* cur = thread_current();
+	enum intr_level old_level;
+#ifdef LOCK_PROFILE
+	int64_t wait_start;
+#endif
+
 	ASSERT(lock != NULL);
 	ASSERT(!intr_context());
 	ASSERT(!lock_held_by_current_thread(lock));
 
+	old_level = intr_disable();
+#ifdef LOCK_PROFILE
+	wait_start = lock->semaphore.value == 0 ? timer_clock_us() : -1;
+#endif
+	if (lock->holder != NULL && !thread_mlfqs) {
+		cur->waiting_lock = lock;
+		list_push_back(&lock->holder->donors, &cur->donor_elem);
+		thread_donate_priority(cur);
+	}
+
 	sema_down(&lock->semaphore);
-	lock->holder = thread_current();
+	cur->waiting_lock = NULL;
+	lock->holder = cur;
+#ifdef LOCK_PROFILE
+	lock_profile_acquired(lock, wait_start);
+#endif
+	intr_set_level(old_level);
 }
 
 /* Tries to acquires LOCK and returns true if successful or false
@@ -203,23 +346,43 @@ bool lock_try_acquire(struct lock* lock)
 	ASSERT(!lock_held_by_current_thread(lock));
 
 	success = sema_try_down(&lock->semaphore);
-	if (success)
+	if (success) {
 		lock->holder = thread_current();
+#ifdef LOCK_PROFILE
+		enum intr_level old_level = intr_disable();
+		lock_profile_acquired(lock, -1);
+		intr_set_level(old_level);
+#endif
+	}
 	return success;
 }
 
 /* Releases LOCK, which must be owned by the current thread.
+	Priority donated through LOCK is given back before the
+	highest-priority waiter, if any, is woken.
 
 	An interrupt handler cannot acquire a lock, so it does not
 	make sense to try to release a lock within an interrupt
 	handler. */
 void lock_release(struct lock* lock)
 {
+	enum intr_level old_level;
+
 	ASSERT(lock != NULL);
 	ASSERT(lock_held_by_current_thread(lock));
 
+	old_level = intr_disable();
+#ifdef LOCK_PROFILE
+	lock_profile_released(lock);
+#endif
+	if (!thread_mlfqs)
+		thread_remove_donors(lock);
 	lock->holder = NULL;
 	sema_up(&lock->semaphore);
+	intr_set_level(old_level);
+
+	if (old_level == INTR_ON)
+		thread_preempt();
 }
 
 /* Returns true if the current thread holds LOCK, false
@@ -232,12 +395,354 @@ bool lock_held_by_current_thread(const struct lock* lock)
 	return lock->holder == thread_current();
 }
 
+#ifdef LOCK_PROFILE
+/* Returns the contention profile for locks named NAME, creating
+	it if necessary. */
+static struct lock_site* lock_site_lookup(const char* name)
+{
+	struct lock_site* site;
+	enum intr_level old_level;
+	size_t i;
+
+	old_level = intr_disable();
+	for (i = 0; i < lock_site_cnt; i++)
+		if (!strcmp(lock_sites[i].name, name))
+			break;
+	if (i < lock_site_cnt)
+		site = &lock_sites[i];
+	else if (lock_site_cnt < LOCK_SITE_CNT - 1) {
+		site = &lock_sites[lock_site_cnt++];
+		site->name = name;
+	}
+	else {
+		site = &lock_sites[LOCK_SITE_CNT - 1];
+		site->name = "(other)";
+	}
+	intr_set_level(old_level);
+
+	return site;
+}
+
+/* Records that the current thread has just acquired LOCK, after
+	waiting since WAIT_START if it had to wait or, if it did not,
+	with WAIT_START set to -1.  Must be called with interrupts
+	off. */
+static void lock_profile_acquired(struct lock* lock, int64_t wait_start)
+{
+	struct lock_site* site = lock->site;
+
+	ASSERT(intr_get_level() == INTR_OFF);
+
+	lock->acquire_time = timer_clock_us();
+	site->acquired++;
+	if (wait_start >= 0) {
+		int64_t wait = lock->acquire_time - wait_start;
+		site->contended++;
+		site->wait_total += wait;
+		if (wait > site->wait_max)
+			site->wait_max = wait;
+	}
+}
+
+/* Records that the current thread is about to release LOCK.
+	Must be called with interrupts off. */
+static void lock_profile_released(struct lock* lock)
+{
+	int64_t hold = timer_clock_us() - lock->acquire_time;
+
+	ASSERT(intr_get_level() == INTR_OFF);
+
+	if (hold > lock->site->hold_max)
+		lock->site->hold_max = hold;
+}
+
+/* Prints the LOCK_REPORT_CNT lock profiles with the most total
+	wait time. */
+void lock_print_stats(void)
+{
+	struct lock_site* sorted[LOCK_SITE_CNT];
+	size_t cnt, i, j;
+
+	/* Insertion sort by decreasing total wait, then by decreasing
+		number of acquisitions. */
+	cnt = lock_site_cnt + (lock_sites[LOCK_SITE_CNT - 1].name != NULL);
+	for (i = 0; i < cnt; i++) {
+		struct lock_site* site = &lock_sites[i];
+		for (j = i; j > 0; j--) {
+			struct lock_site* prev = sorted[j - 1];
+			if (prev->wait_total > site->wait_total
+				 || (prev->wait_total == site->wait_total && prev->acquired >= site->acquired))
+				break;
+			sorted[j] = prev;
+		}
+		sorted[j] = site;
+	}
+
+	printf("Locks: %zu profiled names\n", cnt);
+	for (i = 0; i < cnt && i < LOCK_REPORT_CNT; i++) {
+		struct lock_site* site = sorted[i];
+		if (site->acquired == 0)
+			break;
+		printf(
+			 "  %s: %u acquired, %u contended, waited %" PRId64 " us (max %" PRId64
+			 "), held max %" PRId64 " us\n",
+			 site->name,
+			 site->acquired,
+			 site->contended,
+			 site->wait_total,
+			 site->wait_max,
+			 site->hold_max);
+	}
+}
+#endif
+
+/* Initializes RW as a readers-writer lock held by nobody.  Any
+	number of threads may hold it to read at once, but a thread
+	holding it to write excludes all others.
+
+	Writers are preferred: once a writer waits, new readers wait
+	too, so that a stream of readers cannot starve writers.  When
+	the lock becomes free it goes to the highest-priority waiting
+	writer, unless a waiting reader has a higher priority, in
+	which case all waiting readers get it together.  Unlike
+	struct lock, a readers-writer lock does not donate priority.
+
+	The lock is handed directly to the threads it wakes, so they
+	need not compete for it again. */
+void rwlock_init(struct rwlock* rw)
+{
+	ASSERT(rw != NULL);
+
+	rw->readers = 0;
+	rw->writer = NULL;
+	list_init(&rw->read_waiters);
+	list_init(&rw->write_waiters);
+}
+
+/* Hands RW, which nobody holds, to the waiters chosen as
+	described above rwlock_init().  Must be called with interrupts
+	off. */
+static void rwlock_wake(struct rwlock* rw)
+{
+	struct thread* writer = NULL;
+	int read_priority = PRI_MIN - 1;
+
+	ASSERT(intr_get_level() == INTR_OFF);
+	ASSERT(rw->readers == 0 && rw->writer == NULL);
+
+	if (!list_empty(&rw->write_waiters))
+		writer = list_entry(
+			 list_max(&rw->write_waiters, thread_priority_less, NULL), struct thread, elem);
+	if (!list_empty(&rw->read_waiters))
+		read_priority = list_entry(
+			 list_max(&rw->read_waiters, thread_priority_less, NULL), struct thread, elem)->priority;
+
+	if (writer != NULL && writer->priority >= read_priority) {
+		list_remove(&writer->elem);
+		rw->writer = writer;
+		thread_unblock(writer);
+	}
+	else
+		while (!list_empty(&rw->read_waiters)) {
+			rw->readers++;
+			thread_unblock(list_entry(list_pop_front(&rw->read_waiters), struct thread, elem));
+		}
+}
+
+/* Acquires RW to read, sleeping until no thread holds or is
+	waiting to acquire it to write.
+
+	This function may sleep, so it must not be called within an
+	interrupt handler. */
+void rwlock_acquire_read(struct rwlock* rw)
+{
+	enum intr_level old_level;
+
+	ASSERT(rw != NULL);
+	ASSERT(!intr_context());
+	ASSERT(rw->writer != thread_current());
+
+	old_level = intr_disable();
+	if (rw->writer != NULL || !list_empty(&rw->write_waiters)) {
+		/* rwlock_wake() counts us as a reader before waking us. */
+		list_push_back(&rw->read_waiters, &thread_current()->elem);
+		thread_block();
+	}
+	else
+		rw->readers++;
+	intr_set_level(old_level);
+}
+
+/* Tries to acquire RW to read without sleeping.  Returns true if
+	successful, false if a thread holds or is waiting to acquire
+	RW to write.
+
+	This function will not sleep, so it may be called within an
+	interrupt handler. */
+bool rwlock_try_acquire_read(struct rwlock* rw)
+{
+	enum intr_level old_level;
+	bool success;
+
+	ASSERT(rw != NULL);
+
+	old_level = intr_disable();
+	success = rw->writer == NULL && list_empty(&rw->write_waiters);
+	if (success)
+		rw->readers++;
+	intr_set_level(old_level);
+
+	return success;
+}
+
+/* Releases RW, which the current thread must hold to read.  The
+	last reader out hands the lock to the waiters, if any. */
+void rwlock_release_read(struct rwlock* rw)
+{
+	enum intr_level old_level;
+
+	ASSERT(rw != NULL);
+
+	old_level = intr_disable();
+	ASSERT(rw->readers > 0);
+	if (--rw->readers == 0)
+		rwlock_wake(rw);
+	intr_set_level(old_level);
+
+	if (old_level == INTR_ON)
+		thread_preempt();
+}
+
+/* Acquires RW to write, sleeping until no other thread holds
+	it.
+
+	This function may sleep, so it must not be called within an
+	interrupt handler. */
+void rwlock_acquire_write(struct rwlock* rw)
+{
+	struct thread* cur = thread_current();
+	enum intr_level old_level;
+
+	ASSERT(rw != NULL);
+	ASSERT(!intr_context());
+	ASSERT(rw->writer != cur);
+
+	old_level = intr_disable();
+	if (rw->writer != NULL || rw->readers > 0) {
+		/* rwlock_wake() makes us the writer before waking us. */
+		list_push_back(&rw->write_waiters, &cur->elem);
+		thread_block();
+	}
+	else
+		rw->writer = cur;
+	intr_set_level(old_level);
+}
+
+/* Tries to acquire RW to write without sleeping.  Returns true
+	if successful, false if any thread holds RW.
+
+	This function will not sleep, so it may be called within an
+	interrupt handler. */
+bool rwlock_try_acquire_write(struct rwlock* rw)
+{
+	enum intr_level old_level;
+	bool success;
+
+	ASSERT(rw != NULL);
+
+	old_level = intr_disable();
+	success = rw->writer == NULL && rw->readers == 0;
+	if (success)
+		rw->writer = thread_current();
+	intr_set_level(old_level);
+
+	return success;
+}
+
+/* Releases RW, which the current thread must hold to write, and
+	hands it to the waiters, if any. */
+void rwlock_release_write(struct rwlock* rw)
+{
+	enum intr_level old_level;
+
+	ASSERT(rw != NULL);
+	ASSERT(rw->writer == thread_current());
+
+	old_level = intr_disable();
+	rw->writer = NULL;
+	rwlock_wake(rw);
+	intr_set_level(old_level);
+
+	if (old_level == INTR_ON)
+		thread_preempt();
+}
+
+/* State shared with the writer thread of rwlock_self_test(). */
+struct rwlock_test {
+	struct rwlock rw; /* Lock under test. */
+	int value;			/* Protected by RW. */
+};
+
+static void rwlock_test_writer(void* test_);
+
+/* Self-test for readers-writer locks.  Checks that readers share
+	the lock, and that a waiting writer holds off new readers and
+	gets the lock as soon as the last reader releases it.  Assumes
+	the priority scheduler. */
+void rwlock_self_test(void)
+{
+	struct rwlock_test test;
+
+	printf("Testing rwlocks...");
+	rwlock_init(&test.rw);
+	test.value = 0;
+
+	rwlock_acquire_read(&test.rw);
+	ASSERT(rwlock_try_acquire_read(&test.rw));
+	ASSERT(!rwlock_try_acquire_write(&test.rw));
+	rwlock_release_read(&test.rw);
+
+	/* The writer preempts us and blocks. */
+	thread_create("rwlock-test", PRI_DEFAULT + 1, rwlock_test_writer, &test);
+	ASSERT(!rwlock_try_acquire_read(&test.rw));
+	ASSERT(test.value == 0);
+
+	/* The writer preempts us again and finishes. */
+	rwlock_release_read(&test.rw);
+	ASSERT(test.value == 1);
+	ASSERT(rwlock_try_acquire_write(&test.rw));
+	rwlock_release_write(&test.rw);
+	printf("done.\n");
+}
+
+/* Thread function used by rwlock_self_test(). */
+static void rwlock_test_writer(void* test_)
+{
+	struct rwlock_test* test = test_;
+
+	rwlock_acquire_write(&test->rw);
+	test->value++;
+	rwlock_release_write(&test->rw);
+}
+
 /* One semaphore in a list. */
 struct semaphore_elem {
 	struct list_elem elem;		 /* List element. */
 	struct semaphore semaphore; /* This semaphore. */
+	struct thread* thread;		 /* Thread waiting on the semaphore. */
 };
 
+/* Returns true if the thread waiting on semaphore_elem A has
+	lower priority than the one waiting on B. */
+static bool waiter_priority_less(
+	 const struct list_elem* a_, const struct list_elem* b_, void* aux UNUSED)
+{
+	const struct semaphore_elem* a = list_entry(a_, struct semaphore_elem, elem);
+	const struct semaphore_elem* b = list_entry(b_, struct semaphore_elem, elem);
+
+	return a->thread->priority < b->thread->priority;
+}
+
 /* Initializes condition variable COND.  A condition variable
 	allows one piece of code to signal a condition and cooperating
 	code to receive the signal and act upon it. */
@@ -278,15 +783,51 @@ void cond_wait(struct condition* cond, struct lock* lock)
 	ASSERT(lock_held_by_current_thread(lock));
 
 	sema_init(&waiter.semaphore, 0);
+	waiter.thread = thread_current();
 	list_push_back(&cond->waiters, &waiter.elem);
 	lock_release(lock);
 	sema_down(&waiter.semaphore);
 	lock_acquire(lock);
 }
 
+/* Like cond_wait(), but gives up waiting for COND to be signaled
+	once TICKS timer ticks have passed.  Either way, LOCK is
+	reacquired before returning.  Returns true if COND was
+	signaled, false if the wait timed out.
+
+	This function may sleep, so it must not be called within an
+	interrupt handler. */
+bool cond_wait_timeout(struct condition* cond, struct lock* lock, int64_t ticks)
+{
+	struct semaphore_elem waiter;
+	bool signaled;
+
+	ASSERT(cond != NULL);
+	ASSERT(lock != NULL);
+	ASSERT(!intr_context());
+	ASSERT(lock_held_by_current_thread(lock));
+
+	sema_init(&waiter.semaphore, 0);
+	waiter.thread = thread_current();
+	list_push_back(&cond->waiters, &waiter.elem);
+	lock_release(lock);
+	signaled = sema_down_timeout(&waiter.semaphore, ticks);
+	lock_acquire(lock);
+
+	/* A signal may have arrived after the timeout but before we
+		got LOCK back.  Now that we hold LOCK, either it did and
+		our semaphore was upped, or we are still on the list. */
+	if (!signaled && !sema_try_down(&waiter.semaphore))
+		list_remove(&waiter.elem);
+	else
+		signaled = true;
+	return signaled;
+}
+
 /* If any threads are waiting on COND (protected by LOCK), then
-	this function signals one of them to wake up from its wait.
-	LOCK must be held before calling this function.
+	this function signals the highest-priority one of them to wake
+	up from its wait.  LOCK must be held before calling this
+	function.
 
 	An interrupt handler cannot acquire a lock, so it does not
 	make sense to try to signal a condition variable within an
@@ -298,9 +839,11 @@ void cond_signal(struct condition* cond, struct lock* lock UNUSED)
 	ASSERT(!intr_context());
 	ASSERT(lock_held_by_current_thread(lock));
 
-	if (!list_empty(&cond->waiters))
-		sema_up(&list_entry(list_pop_front(&cond->waiters), struct semaphore_elem, elem)
-						 ->semaphore);
+	if (!list_empty(&cond->waiters)) {
+		struct list_elem* e = list_max(&cond->waiters, waiter_priority_less, NULL);
+		list_remove(e);
+		sema_up(&list_entry(e, struct semaphore_elem, elem)->semaphore);
+	}
 }
 
 /* Wakes up all threads, if any, waiting on COND (protected by
@@ -316,3 +859,58 @@ void cond_broadcast(struct condition* cond, struct lock* lock)
 
 	while (!list_empty(&cond->waiters)) cond_signal(cond, lock);
 }
+
+/* State shared with the helper thread of
+	synch_timeout_self_test(). */
+struct timeout_test {
+	struct semaphore sema;
+	struct lock lock;
+	struct condition cond;
+};
+
+static void timeout_test_helper(void* test_);
+
+/* Self-test for sema_down_timeout() and cond_wait_timeout().
+	Checks that each times out when nothing wakes it, and returns
+	early when something does.  Assumes the priority scheduler. */
+void synch_timeout_self_test(void)
+{
+	struct timeout_test test;
+	int64_t start;
+
+	printf("Testing timeouts...");
+	sema_init(&test.sema, 0);
+	lock_init_named(&test.lock, "timeout-test");
+	cond_init(&test.cond);
+
+	start = timer_ticks();
+	ASSERT(!sema_down_timeout(&test.sema, 5));
+	ASSERT(timer_elapsed(start) >= 5);
+	ASSERT(list_empty(&test.sema.waiters));
+
+	lock_acquire(&test.lock);
+	ASSERT(!cond_wait_timeout(&test.cond, &test.lock, 5));
+	ASSERT(list_empty(&test.cond.waiters));
+	lock_release(&test.lock);
+
+	/* The helper only runs while we wait. */
+	thread_create("timeout-test", PRI_DEFAULT - 1, timeout_test_helper, &test);
+	start = timer_ticks();
+	ASSERT(sema_down_timeout(&test.sema, 1000));
+	lock_acquire(&test.lock);
+	ASSERT(cond_wait_timeout(&test.cond, &test.lock, 1000));
+	lock_release(&test.lock);
+	ASSERT(timer_elapsed(start) < 1000);
+	printf("done.\n");
+}
+
+/* Thread function used by synch_timeout_self_test(). */
+static void timeout_test_helper(void* test_)
+{
+	struct timeout_test* test = test_;
+
+	sema_up(&test->sema);
+	lock_acquire(&test->lock);
+	cond_signal(&test->cond, &test->lock);
+	lock_release(&test->lock);
+}
@@ -3,6 +3,7 @@
 
 #include <list.h>
 #include <stdbool.h>
+#include <stdint.h>
 
 /* A counting semaphore. */
 struct semaphore {
@@ -12,6 +13,7 @@ struct semaphore {
 
 void sema_init(struct semaphore*, unsigned value);
 void sema_down(struct semaphore*);
+bool sema_down_timeout(struct semaphore*, int64_t ticks);
 bool sema_try_down(struct semaphore*);
 void sema_up(struct semaphore*);
 void sema_self_test(void);
@@ -20,9 +22,14 @@ void sema_self_test(void);
 struct lock {
 	struct thread* holder;		 /* Thread holding lock (for debugging). */
 	struct semaphore semaphore; /* Binary semaphore controlling access. */
+#ifdef LOCK_PROFILE
+	struct lock_site* site; /* Profile shared by locks with our name. */
+	int64_t acquire_time;	/* When the holder acquired us, in us. */
+#endif
 };
 
 void lock_init(struct lock*);
+void lock_init_named(struct lock*, const char* name);
 void lock_acquire(struct lock*);
 bool lock_try_acquire(struct lock*);
 void lock_release(struct lock*);
@@ -33,10 +40,46 @@ struct condition {
 	struct list waiters; /* List of waiting threads. */
 };
 
+/* Readers-writer lock. */
+struct rwlock {
+	unsigned readers;				  /* Number of threads holding it to read. */
+	struct thread* writer;		  /* Thread holding it to write, if any. */
+	struct list read_waiters;	  /* Threads waiting to read. */
+	struct list write_waiters;	  /* Threads waiting to write. */
+};
+
+void rwlock_init(struct rwlock*);
+void rwlock_acquire_read(struct rwlock*);
+bool rwlock_try_acquire_read(struct rwlock*);
+void rwlock_release_read(struct rwlock*);
+void rwlock_acquire_write(struct rwlock*);
+bool rwlock_try_acquire_write(struct rwlock*);
+void rwlock_release_write(struct rwlock*);
+void rwlock_self_test(void);
+
+#ifdef LOCK_PROFILE
+/* Contention profile of all the locks initialized with a given
+	name.  Kernels built with -DLOCK_PROFILE keep one per name and
+	print the most contended at power off; otherwise lock names
+	are ignored and locks are not profiled. */
+struct lock_site {
+	const char* name;		 /* Name passed to lock_init_named(). */
+	unsigned acquired;	 /* Number of acquisitions. */
+	unsigned contended;	 /* Acquisitions that had to wait. */
+	int64_t wait_total;	 /* Total time spent waiting, in us. */
+	int64_t wait_max;		 /* Longest wait, in us. */
+	int64_t hold_max;		 /* Longest time held, in us. */
+};
+
+void lock_print_stats(void);
+#endif
+
 void cond_init(struct condition*);
 void cond_wait(struct condition*, struct lock*);
+bool cond_wait_timeout(struct condition*, struct lock*, int64_t ticks);
 void cond_signal(struct condition*, struct lock*);
 void cond_broadcast(struct condition*, struct lock*);
+void synch_timeout_self_test(void);
 
 /* Optimization barrier.
 
@@ -1,15 +1,23 @@
 #include "threads/thread.h"
 
+#include "devices/timer.h"
+#include "threads/cpu.h"
+#include "threads/fixed-point.h"
 #include "threads/flags.h"
 #include "threads/interrupt.h"
 #include "threads/intr-stubs.h"
+#include "threads/malloc.h"
 #include "threads/palloc.h"
+#include "threads/smp.h"
 #include "threads/switch.h"
 #include "threads/synch.h"
+#include "threads/trace.h"
 #include "threads/vaddr.h"
 
 #include <debug.h>
+#include <inttypes.h>
 #include <random.h>
+#include <round.h>
 #include <stddef.h>
 #include <stdio.h>
 #include <string.h>
@@ -22,20 +30,57 @@
 	of thread.h for details. */
 #define THREAD_MAGIC 0xcd6abf4b
 
-/* List of processes in THREAD_READY state, that is, processes
-	that are ready to run but not actually running. */
-static struct list ready_list;
+/* Run queues of processes in THREAD_READY state, that is,
+	processes that are ready to run but not actually running.
+	Each CPU has a run queue of its own, and a ready thread waits
+	in the run queue of its `cpu', normally the CPU it last ran
+	on.  A CPU whose run queue is empty takes a thread from the
+	CPU with the most ready threads instead of idling.
+
+	Within a run queue there is one FIFO queue per priority
+	level.  Bit P of `bitmap' is set if and only if queues[P] is
+	nonempty, so the highest-priority ready thread is found with
+	a single find-first-set instead of a scan.  The completely
+	fair scheduler and the earliest-deadline-first class keep
+	their ready threads in trees instead (see below). */
+#define READY_WORD_BITS 32
+#define READY_WORD_CNT ((PRI_MAX + 1 + READY_WORD_BITS - 1) / READY_WORD_BITS)
+struct run_queue {
+	struct list queues[PRI_MAX + 1]; /* Ready threads by priority. */
+	uint32_t bitmap[READY_WORD_CNT];	/* Nonempty queues[]. */
+	int cnt;									/* Number of ready threads. */
+	struct rb_tree cfs;					/* CFS ready threads by vruntime. */
+	int64_t cfs_min_vruntime;			/* Never decreases. */
+	int cfs_nr_running;					/* Runnable threads here, except idle. */
+	long cfs_load;							/* Total weight of the same. */
+	struct rb_tree edf;					/* EDF ready threads by deadline. */
+};
+static struct run_queue run_queues[CPU_MAX];
+static unsigned steals; /* Threads taken from another CPU's queue. */
 
 /* List of all processes.  Processes are added to this list
 	when they are first scheduled and removed when they exit. */
 static struct list all_list;
 
-/* Idle thread. */
-static struct thread* idle_thread;
+/* Per-CPU state.  Until smp_init() finds more, there is only
+	the bootstrap processor. */
+struct cpu cpus[CPU_MAX];
+int cpu_cnt = 1;
 
 /* Initial thread, the thread running init.c:main(). */
 static struct thread* initial_thread;
 
+/* Pages of dead threads kept for reuse by thread_create(), which
+	saves a trip through the page allocator and the cost of
+	zeroing a whole page for each new thread.  Only the `struct
+	thread' and the initial stack frames of a new thread are
+	cleared. */
+#define PAGE_CACHE_MAX 16
+static void* page_cache[PAGE_CACHE_MAX];
+static size_t page_cache_cnt;
+static unsigned page_cache_hits;	  /* Pages reused from the cache. */
+static unsigned page_cache_misses; /* Pages taken from palloc. */
+
 /* Lock used by allocate_tid(). */
 static struct lock tid_lock;
 
@@ -50,27 +95,136 @@ struct kernel_thread_frame {
 static long long idle_ticks;	 /* # of timer ticks spent idle. */
 static long long kernel_ticks; /* # of timer ticks in kernel threads. */
 static long long user_ticks;	 /* # of timer ticks in user programs. */
+static int64_t idle_ns;			 /* Nanoseconds spent idle. */
+static int64_t kernel_ns;		 /* Nanoseconds in kernel threads. */
+static int64_t user_ns;			 /* Nanoseconds in user programs. */
+static struct sched_stats sched_stats; /* Sum over all threads. */
 
 /* Scheduling. */
 #define TIME_SLICE 4				/* # of timer ticks to give each thread. */
-static unsigned thread_ticks; /* # of timer ticks since last yield. */
+#define DONATION_DEPTH 8		/* Max length of a donation chain. */
 
 /* If false (default), use round-robin scheduler.
 	If true, use multi-level feedback queue scheduler.
 	Controlled by kernel command-line option "-o mlfqs". */
 bool thread_mlfqs;
 
+/* Multi-level feedback queue scheduler.  load_avg and each
+	thread's recent_cpu are recomputed for every thread once per
+	second; between those updates only the running thread's
+	recent_cpu changes, so only its priority needs recomputing
+	every MLFQS_PRIORITY_TICKS ticks. */
+#define MLFQS_PRIORITY_TICKS 4 /* Ticks between priority updates. */
+static fixed_t load_avg;		  /* Estimated ready threads, last minute. */
+
+/* If true, use the completely fair scheduler.  Controlled by
+	kernel command-line option "-cfs". */
+bool thread_cfs;
+
+/* Completely fair scheduler.  Ready threads are kept in a
+	red-black tree ordered by virtual runtime, the CPU time each
+	has received scaled down by its weight, and the thread that
+	has received least runs next.  Weights fall by about 20% for
+	each step of niceness.  The running thread's slice is its
+	weighted share of CFS_LATENCY, the period in which every
+	runnable thread should run once, but no shorter than
+	CFS_MIN_GRANULARITY.
+
+	Threads also belong to scheduling groups, normally one per
+	process.  A thread's weight is divided among the runnable
+	threads of its group, so a group with many runnable threads
+	gets about as much CPU time as one with a single thread. */
+#define CFS_LATENCY 40000				 /* Scheduling period, in us. */
+#define CFS_MIN_GRANULARITY 10000	 /* Shortest slice, in us. */
+#define CFS_WAKEUP_GRANULARITY 5000 /* Lead needed to preempt, in us. */
+#define CFS_NICE_0_WEIGHT 1024		 /* Weight at nice 0. */
+static const int cfs_weights[NICE_MAX - NICE_MIN + 1] = {
+	 88761, 71755, 56483, 46273, 36291, 29154, 23254, 18705, 14949, 11916, 9548,
+	 7620,  6100,  4904,  3906,  3121,  2501,  1991,  1586,  1277,  1024,  820,
+	 655,	  526,	423,	 335,	  272,	215,	 172,	  137,	110,	 87,	  70,
+	 56,	  45,		36,	 29,	  23,		18,	 15,	  12};
+
+/* A group of threads that shares the CPU fairly with other
+	groups under the completely fair scheduler. */
+struct sched_group {
+	int runnable; /* Number of runnable members. */
+	int refs;	  /* Number of members. */
+};
+static struct sched_group root_group; /* Group of the initial thread. */
+
+/* Earliest-deadline-first class.  A thread that reserves BUDGET
+	ticks of CPU time in every PERIOD ticks with
+	thread_set_deadline() runs ahead of every thread outside the
+	class, whatever the scheduler, and among threads in the class
+	the one whose period ends first runs first.  A thread that
+	uses up its budget is throttled: it competes like any other
+	thread until its next period begins.
+
+	A reservation is admitted only if the total utilization of
+	all reservations, the sum of BUDGET / PERIOD, stays within
+	EDF_UTIL_MAX.  Under EDF that guarantees each thread its
+	budget before each deadline, and it leaves the rest of the CPU
+	to the other threads.
+
+	A periodic thread is expected to block, normally in
+	timer_sleep(), once its work for a period is done.  One that
+	is still runnable when its period ends, without having
+	blocked since the period began, has missed its deadline. */
+#define EDF_UTIL_SCALE 1000 /* Utilization of the whole CPU. */
+#define EDF_UTIL_MAX 900	 /* Largest total utilization admitted. */
+static struct list edf_list;		/* Threads with reservations. */
+static int edf_util;					/* Total utilization reserved. */
+static unsigned edf_misses;		/* Deadline misses, all threads. */
+static unsigned edf_throttles;	/* Budget overruns, all threads. */
+
 static void kernel_thread(thread_func*, void* aux);
 
 static void idle(void* aux UNUSED);
+static void idle_loop(void) NO_RETURN;
 static struct thread* running_thread(void);
 static struct thread* next_thread_to_run(void);
 static void init_thread(struct thread*, const char* name, int priority);
 static bool is_thread(struct thread*) UNUSED;
+static bool is_idle_thread(const struct thread*);
 static void* alloc_frame(struct thread*, size_t size);
 static void schedule(void);
+static void sched_account_switch(struct thread*);
+static void sched_charge_time(struct thread*);
 void thread_schedule_tail(struct thread* prev);
 static tid_t allocate_tid(void);
+static struct thread* thread_page_get(void);
+static void thread_page_free(struct thread*);
+static void set_effective_priority(struct thread*, int priority);
+static void refresh_priority(struct thread*);
+static void mlfqs_tick(struct thread*);
+static int mlfqs_priority(const struct thread*);
+static void mlfqs_update_thread(struct thread*, void* aux);
+static struct run_queue* cpu_rq(const struct cpu*);
+static void ready_queue_push(struct thread*);
+static void ready_queue_remove(struct thread*);
+static struct thread* ready_queue_pop(struct run_queue*);
+static int ready_queue_max_priority(const struct run_queue*);
+static bool should_preempt(struct cpu*);
+static bool cpu_idle(const struct cpu*);
+static bool all_cpus_idle(void);
+static struct cpu* busiest_cpu(const struct cpu*);
+static struct cpu* wake_cpu(const struct thread*);
+static void thread_move(struct thread*, struct cpu*);
+static bool cfs_less(const struct rb_elem*, const struct rb_elem*, void* aux);
+static long cfs_weight(const struct thread*);
+static void cfs_update_curr(struct thread*);
+static bool cfs_tick(struct thread*);
+static bool cfs_should_preempt(struct thread*);
+static void sched_set_runnable(struct thread*, bool runnable);
+static void cfs_account(struct run_queue*, const struct thread*, int delta);
+static bool edf_active(const struct thread*);
+static bool edf_less(const struct rb_elem*, const struct rb_elem*, void* aux);
+static bool edf_tick(struct thread*);
+static void edf_release(int64_t now);
+static bool edf_should_preempt(struct thread*);
+static void sched_hist_add(unsigned hist[], int64_t us);
+static void sched_hist_print(const char* name, const unsigned hist[]);
+static void sched_stats_print(const char* name, const struct sched_stats*);
 
 /* Initializes the threading system by transforming the code
 	that's currently running into a thread.  This can't work in
@@ -88,10 +242,20 @@ static tid_t allocate_tid(void);
 	finishes. */
 void thread_init(void)
 {
+	int i;
+
 	ASSERT(intr_get_level() == INTR_OFF);
 
-	lock_init(&tid_lock);
-	list_init(&ready_list);
+	lock_init_named(&tid_lock, "tid");
+	for (i = 0; i < CPU_MAX; i++) {
+		struct run_queue* rq = &run_queues[i];
+		int pri;
+
+		for (pri = PRI_MIN; pri <= PRI_MAX; pri++) list_init(&rq->queues[pri]);
+		rb_init(&rq->cfs, cfs_less, NULL);
+		rb_init(&rq->edf, edf_less, NULL);
+	}
+	list_init(&edf_list);
 	list_init(&all_list);
 
 	/* Set up a thread structure for the running thread. */
@@ -99,6 +263,12 @@ void thread_init(void)
 	init_thread(initial_thread, "main", PRI_DEFAULT);
 	initial_thread->status = THREAD_RUNNING;
 	initial_thread->tid = allocate_tid();
+	initial_thread->group = &root_group;
+	initial_thread->cpu = &cpus[0];
+	root_group.refs = 1;
+	sched_set_runnable(initial_thread, true);
+	cpus[0].curr = initial_thread;
+	cpus[0].started = true;
 }
 
 /* Starts preemptive thread scheduling by enabling interrupts.
@@ -112,7 +282,6 @@ void thread_start(void)
 
 	/* Start preemptive thread scheduling. */
 	intr_enable();
-#include "userprog/syscall.h"
 
 	/* Wait for the idle thread to initialize idle_thread. */
 	sema_down(&idle_started);
@@ -122,10 +291,13 @@ void thread_start(void)
 	Thus, this function runs in an external interrupt context. */
 void thread_tick(void)
 {
+	struct cpu* c = cpu_current();
 	struct thread* t = thread_current();
 
+	c->ticks++;
+
 	/* Update statistics. */
-	if (t == idle_thread)
+	if (is_idle_thread(t))
 		idle_ticks++;
 #ifdef USERPROG
 	if (t->pagedir != NULL){
@@ -135,19 +307,191 @@ void thread_tick(void)
 	else
 		kernel_ticks++;
 
-	/* Enforce preemption. */
-	if (++thread_ticks >= TIME_SLICE)
+	if (thread_mlfqs)
+		mlfqs_tick(t);
+
+	/* Enforce preemption.  A thread in the earliest-deadline-first
+		class runs until it blocks, is preempted by an earlier
+		deadline, or uses up its budget. */
+	if (edf_active(t)) {
+		if (edf_tick(t))
+			intr_yield_on_return();
+	}
+	else if (thread_cfs) {
+		if (!is_idle_thread(t) && cfs_tick(t))
+			intr_yield_on_return();
+	}
+	else if (++c->thread_ticks >= TIME_SLICE)
+		intr_yield_on_return();
+
+	/* An idle CPU looks for threads to take from busy ones. */
+	if (is_idle_thread(t) && busiest_cpu(c) != NULL)
 		intr_yield_on_return();
+
+	/* Start new periods for the threads in the class.  The
+		bootstrap processor does this for all CPUs. */
+	if (c->id == 0 && !list_empty(&edf_list))
+		edf_release(timer_ticks());
 }
 
-/* Prints thread statistics. */
+/* Performs the multi-level feedback queue scheduler's per-tick
+	work for T, the running thread.  Runs in the timer interrupt
+	handler. */
+static void mlfqs_tick(struct thread* t)
+{
+	struct cpu* c = cpu_current();
+
+	if (!is_idle_thread(t))
+		t->recent_cpu = fp_add_int(t->recent_cpu, 1);
+
+	if (c->id == 0 && c->ticks % TIMER_FREQ == 0) {
+		/* Once per second, age load_avg and every thread's
+			recent_cpu.  This is the only walk over all threads,
+			and the bootstrap processor does it for all CPUs. */
+		int ready_threads = 0;
+		int i;
+
+		for (i = 0; i < cpu_cnt; i++)
+			if (cpus[i].started)
+				ready_threads += cpu_rq(&cpus[i])->cnt + (!is_idle_thread(cpus[i].curr) ? 1 : 0);
+		load_avg = fp_add(
+			 fp_mul(fp_div_int(fp_from_int(59), 60), load_avg),
+			 fp_mul_int(fp_div_int(fp_from_int(1), 60), ready_threads));
+		thread_foreach(mlfqs_update_thread, NULL);
+		thread_preempt();
+	}
+	else if (c->ticks % MLFQS_PRIORITY_TICKS == 0 && !is_idle_thread(t)) {
+		/* Only the running thread's recent_cpu has changed since
+			the last update. */
+		set_effective_priority(t, mlfqs_priority(t));
+		thread_preempt();
+	}
+}
+
+/* Recomputes T's recent_cpu from load_avg and then its
+	priority.  Used as a thread_foreach() callback. */
+static void mlfqs_update_thread(struct thread* t, void* aux UNUSED)
+{
+	fixed_t twice_load = fp_mul_int(load_avg, 2);
+
+	if (is_idle_thread(t))
+		return;
+
+	t->recent_cpu = fp_add_int(
+		 fp_mul(fp_div(twice_load, fp_add_int(twice_load, 1)), t->recent_cpu), t->nice);
+	set_effective_priority(t, mlfqs_priority(t));
+}
+
+/* Returns the priority the multi-level feedback queue scheduler
+	assigns to T, PRI_MAX - recent_cpu / 4 - nice * 2 truncated
+	to an integer and clamped to the valid range. */
+static int mlfqs_priority(const struct thread* t)
+{
+	int priority = fp_to_int(
+		 fp_sub_int(fp_sub(fp_from_int(PRI_MAX), fp_div_int(t->recent_cpu, 4)), t->nice * 2));
+
+	if (priority < PRI_MIN)
+		priority = PRI_MIN;
+	else if (priority > PRI_MAX)
+		priority = PRI_MAX;
+	return priority;
+}
+
+/* Accounts for CNT timer ticks that passed without a timer
+	interrupt, as happens while the idle thread has stopped the
+	tick.  Runs in an external interrupt context. */
+void thread_ticks_skipped(int64_t cnt)
+{
+	cpu_current()->ticks += cnt;
+	if (is_idle_thread(thread_current()))
+		idle_ticks += cnt;
+	else
+		kernel_ticks += cnt;
+}
+
+/* Prints thread statistics, followed by the scheduling
+	statistics of the system and, in kernels built with
+	-DSCHED_STATS, of each thread still alive. */
 void thread_print_stats(void)
 {
+	struct list_elem* e;
+	enum intr_level old_level;
+
 	printf(
 		 "Thread: %lld idle ticks, %lld kernel ticks, %lld user ticks\n",
 		 idle_ticks,
 		 kernel_ticks,
 		 user_ticks);
+	printf(
+		 "Thread: %" PRId64 " ns idle, %" PRId64 " ns kernel, %" PRId64 " ns user\n",
+		 idle_ns,
+		 kernel_ns,
+		 user_ns);
+	printf("Thread: %u page cache hits, %u misses\n", page_cache_hits, page_cache_misses);
+	if (cpu_cnt > 1)
+		printf("Thread: %d CPUs, %u threads taken from another CPU\n", cpu_cnt, steals);
+
+	old_level = intr_disable();
+	sched_stats_print("all threads", &sched_stats);
+#ifdef SCHED_STATS
+	for (e = list_begin(&all_list); e != list_end(&all_list); e = list_next(e)) {
+		struct thread* t = list_entry(e, struct thread, allelem);
+		if (!is_idle_thread(t))
+			sched_stats_print(t->name, &t->stats);
+	}
+#endif
+	printf("Deadline: %u misses, %u throttled\n", edf_misses, edf_throttles);
+	for (e = list_begin(&edf_list); e != list_end(&edf_list); e = list_next(e)) {
+		struct thread* t = list_entry(e, struct thread, edf_list_elem);
+		printf(
+			 "Deadline: %s: %lld ticks every %lld, %u misses, %u throttled\n",
+			 t->name,
+			 t->edf_budget,
+			 t->edf_period,
+			 t->edf_misses,
+			 t->edf_throttles);
+	}
+	intr_set_level(old_level);
+}
+
+/* Prints the scheduling statistics STATS under the heading
+	NAME. */
+static void sched_stats_print(const char* name, const struct sched_stats* stats)
+{
+	printf(
+		 "Schedule: %s: %u voluntary, %u involuntary switches\n",
+		 name,
+		 stats->voluntary,
+		 stats->involuntary);
+	sched_hist_print("wakeup latency", stats->latency);
+	sched_hist_print("run slice", stats->slice);
+}
+
+/* Prints the nonempty buckets of log2 histogram HIST, each
+	labeled with its lower bound in microseconds. */
+static void sched_hist_print(const char* name, const unsigned hist[])
+{
+	int i;
+
+	printf("  %s (us):", name);
+	for (i = 0; i < SCHED_HIST_BUCKETS; i++)
+		if (hist[i] != 0)
+			printf(" %lu%s:%u", i == 0 ? 0 : 1ul << (i - 1), i == SCHED_HIST_BUCKETS - 1 ? "+" : "", hist[i]);
+	printf("\n");
+}
+
+/* Counts US microseconds in log2 histogram HIST. */
+static void sched_hist_add(unsigned hist[], int64_t us)
+{
+	int bucket = 0;
+
+	/* Negative values, which the PIT clock can produce around a
+		tick, count as 0. */
+	while (us > 0 && bucket < SCHED_HIST_BUCKETS - 1) {
+		us >>= 1;
+		bucket++;
+	}
+	hist[bucket]++;
 }
 
 /* Creates a new kernel thread named NAME with the given initial
@@ -162,27 +506,47 @@ void thread_print_stats(void)
 	scheduled.  Use a semaphore or some other form of
 	synchronization if you need to ensure ordering.
 
-	The code provided sets the new thread's `priority' member to
-	PRIORITY, but no actual priority scheduling is implemented.
-	Priority scheduling is the goal of Problem 1-3. */
+	If PRIORITY is higher than the running thread's priority, the
+	new thread preempts the caller before thread_create()
+	returns. */
 tid_t thread_create(const char* name, int priority, thread_func* function, void* aux)
 {
 	struct thread* t;
 	struct kernel_thread_frame* kf;
 	struct switch_entry_frame* ef;
 	struct switch_threads_frame* sf;
+	enum intr_level old_level;
 	tid_t tid;
 
 	ASSERT(function != NULL);
 
 	/* Allocate thread. */
-	t = palloc_get_page(PAL_ZERO);
+	t = thread_page_get();
 	if (t == NULL)
 		return TID_ERROR;
 
-	/* Initialize thread. */
+	/* Initialize thread.  Under the multi-level feedback queue
+		scheduler, PRIORITY is ignored and the new thread inherits
+		its parent's nice and recent_cpu values instead. */
 	init_thread(t, name, priority);
 	tid = t->tid = allocate_tid();
+	if (thread_mlfqs) {
+		t->nice = thread_current()->nice;
+		t->recent_cpu = thread_current()->recent_cpu;
+		t->priority = t->base_priority = mlfqs_priority(t);
+	}
+
+	/* Join our scheduling group.  Under the completely fair
+		scheduler, start level with the threads that have received
+		least CPU time and inherit our niceness. */
+	old_level = intr_disable();
+	t->group = thread_current()->group;
+	t->group->refs++;
+	t->cpu = cpu_current();
+	t->vruntime = cpu_rq(t->cpu)->cfs_min_vruntime;
+	if (thread_cfs)
+		t->nice = thread_current()->nice;
+	intr_set_level(old_level);
 
 	/* Stack frame for kernel_thread(). */
 	kf = alloc_frame(t, sizeof *kf);
@@ -216,6 +580,7 @@ void thread_block(void)
 	ASSERT(!intr_context());
 	ASSERT(intr_get_level() == INTR_OFF);
 
+	TRACE(TRACE_BLOCK, __builtin_return_address(0), 0);
 	thread_current()->status = THREAD_BLOCKED;
 	schedule();
 }
@@ -224,21 +589,61 @@ void thread_block(void)
 	This is an error if T is not blocked.  (Use thread_yield() to
 	make the running thread ready.)
 
-	This function does not preempt the running thread.  This can
-	be important: if the caller had disabled interrupts itself,
-	it may expect that it can atomically unblock a thread and
-	update other data. */
+	T runs on the CPU it last ran on if that CPU is idle, and
+	otherwise on any idle CPU; if no CPU is idle, it waits on the
+	one it last ran on.  If T has a higher priority than the
+	thread running on that CPU, that thread is preempted.  Within an external interrupt
+	handler the yield is deferred until the interrupt returns.
+	If the caller had disabled interrupts itself, the running
+	thread is not preempted here, because the caller may expect
+	that it can atomically unblock a thread and update other
+	data; such callers should call thread_preempt() once they
+	turn interrupts back on. */
 void thread_unblock(struct thread* t)
 {
 	enum intr_level old_level;
+	int64_t min_vruntime;
 
 	ASSERT(is_thread(t));
 
 	old_level = intr_disable();
 	ASSERT(t->status == THREAD_BLOCKED);
-	list_push_back(&ready_list, &t->elem);
+	TRACE(TRACE_UNBLOCK, t->tid, __builtin_return_address(0));
+	sched_set_runnable(t, true);
+	thread_move(t, wake_cpu(t));
+	min_vruntime = cpu_rq(t->cpu)->cfs_min_vruntime;
+	if (thread_cfs && t->vruntime < min_vruntime - CFS_LATENCY / 2) {
+		/* A thread that slept gets at most half a period of credit
+			against those that kept running. */
+		t->vruntime = min_vruntime - CFS_LATENCY / 2;
+	}
+	ready_queue_push(t);
 	t->status = THREAD_READY;
+	t->wake_time = timer_clock_us();
 	intr_set_level(old_level);
+
+	if (old_level == INTR_ON || intr_context())
+		thread_preempt();
+}
+
+/* Yields the CPU if a ready thread has a higher priority than
+	the running thread.  Within an external interrupt handler,
+	requests a yield on interrupt return instead. */
+void thread_preempt(void)
+{
+	enum intr_level old_level;
+	bool preempt;
+
+	old_level = intr_disable();
+	preempt = should_preempt(cpu_current());
+	intr_set_level(old_level);
+
+	if (!preempt)
+		return;
+	if (intr_context())
+		intr_yield_on_return();
+	else
+		thread_yield();
 }
 
 /* Returns the name of the running thread. */
@@ -275,12 +680,31 @@ tid_t thread_tid(void)
 	returns to the caller. */
 void thread_exit(void)
 {
+	struct thread* cur = thread_current();
+	struct sched_group* group;
+	bool last;
+
 	ASSERT(!intr_context());
 
 #ifdef USERPROG
 	process_exit();
 #endif
 
+	/* Give up our reservation, if any, and leave our scheduling
+		group, freeing it if we were its last member. */
+	intr_disable();
+	if (cur->edf_period != 0) {
+		list_remove(&cur->edf_list_elem);
+		edf_util -= cur->edf_util;
+	}
+	sched_set_runnable(cur, false);
+	group = cur->group;
+	cur->group = NULL;
+	last = --group->refs == 0;
+	intr_enable();
+	if (last && group != &root_group)
+		free(group);
+
 	/* Remove thread from all threads list, set our status to dying,
 		and schedule another process.  That process will destroy us
 		when it calls thread_schedule_tail(). */
@@ -301,8 +725,11 @@ void thread_yield(void)
 	ASSERT(!intr_context());
 
 	old_level = intr_disable();
-	if (cur != idle_thread)
-		list_push_back(&ready_list, &cur->elem);
+	if (!is_idle_thread(cur)) {
+		if (thread_cfs)
+			cfs_update_curr(cur);
+		ready_queue_push(cur);
+	}
 	cur->status = THREAD_READY;
 	schedule();
 	intr_set_level(old_level);
@@ -322,10 +749,73 @@ void thread_foreach(thread_action_func* func, void* aux)
 	}
 }
 
-/* Sets the current thread's priority to NEW_PRIORITY. */
+/* Sets the current thread's base priority to NEW_PRIORITY.  The
+	effective priority stays raised while other threads donate to
+	us.  Yields if the current thread no longer has the highest
+	priority. */
 void thread_set_priority(int new_priority)
 {
-	thread_current()->priority = new_priority;
+	struct thread* cur = thread_current();
+	enum intr_level old_level;
+
+	ASSERT(PRI_MIN <= new_priority && new_priority <= PRI_MAX);
+
+	/* The multi-level feedback queue scheduler sets priorities
+		itself. */
+	if (thread_mlfqs)
+		return;
+
+	old_level = intr_disable();
+	cur->base_priority = new_priority;
+	refresh_priority(cur);
+	intr_set_level(old_level);
+
+	thread_preempt();
+}
+
+/* Donates DONOR's priority along the chain of lock holders that
+	starts with the holder of DONOR->waiting_lock.  Each holder is
+	raised to at least DONOR's priority, stopping at a thread that
+	is not itself waiting on a lock, at a holder that already has
+	a high enough priority, or after DONATION_DEPTH steps.
+
+	Must be called with interrupts off. */
+void thread_donate_priority(struct thread* donor)
+{
+	struct thread* t = donor;
+	int depth;
+
+	ASSERT(intr_get_level() == INTR_OFF);
+
+	for (depth = 0; depth < DONATION_DEPTH && t->waiting_lock != NULL; depth++) {
+		struct thread* holder = t->waiting_lock->holder;
+		if (holder == NULL || holder->priority >= donor->priority)
+			break;
+		set_effective_priority(holder, donor->priority);
+		t = holder;
+	}
+}
+
+/* Forgets the donations made to the running thread by threads
+	waiting on LOCK, which it is about to release, and recomputes
+	its effective priority from those that remain.
+
+	Must be called with interrupts off. */
+void thread_remove_donors(const struct lock* lock)
+{
+	struct thread* cur = thread_current();
+	struct list_elem* e;
+
+	ASSERT(intr_get_level() == INTR_OFF);
+
+	for (e = list_begin(&cur->donors); e != list_end(&cur->donors);) {
+		struct thread* t = list_entry(e, struct thread, donor_elem);
+		if (t->waiting_lock == lock)
+			e = list_remove(e);
+		else
+			e = list_next(e);
+	}
+	refresh_priority(cur);
 }
 
 /* Returns the current thread's priority. */
@@ -334,69 +824,224 @@ int thread_get_priority(void)
 	return thread_current()->priority;
 }
 
-/* Sets the current thread's nice value to NICE. */
-void thread_set_nice(int nice UNUSED)
+/* Sets the current thread's nice value to NICE and recomputes
+	its priority.  Yields if the current thread no longer has the
+	highest priority. */
+void thread_set_nice(int nice)
 {
-	/* Not yet implemented. */
+	struct thread* cur = thread_current();
+	enum intr_level old_level;
+
+	ASSERT(NICE_MIN <= nice && nice <= NICE_MAX);
+
+	old_level = intr_disable();
+	if (thread_cfs)
+		cfs_update_curr(cur);
+	sched_set_runnable(cur, false);
+	cur->nice = nice;
+	sched_set_runnable(cur, true);
+	if (thread_mlfqs)
+		set_effective_priority(cur, mlfqs_priority(cur));
+	intr_set_level(old_level);
+
+	thread_preempt();
+}
+
+/* Moves the running thread into a new scheduling group of its
+	own, which the threads it creates from now on will join too.
+	Under the completely fair scheduler, the group then shares
+	the CPU as one with other groups.  Returns true if successful,
+	false if memory is short, in which case the thread stays in
+	its current group. */
+bool thread_new_sched_group(void)
+{
+	struct thread* cur = thread_current();
+	struct sched_group* group = malloc(sizeof *group);
+	struct sched_group* old;
+	enum intr_level old_level;
+	bool last;
+
+	if (group == NULL)
+		return false;
+	group->runnable = 0;
+	group->refs = 1;
+
+	old_level = intr_disable();
+	if (thread_cfs)
+		cfs_update_curr(cur);
+	sched_set_runnable(cur, false);
+	old = cur->group;
+	cur->group = group;
+	sched_set_runnable(cur, true);
+	last = --old->refs == 0;
+	intr_set_level(old_level);
+
+	if (last && old != &root_group)
+		free(old);
+	return true;
+}
+
+/* Puts the running thread in the earliest-deadline-first class,
+	reserving BUDGET timer ticks of CPU time in every period of
+	PERIOD ticks, the first of which begins now.  A PERIOD of 0
+	returns the thread to its usual class.  Returns true if
+	successful, false if the reservation would overcommit the CPU,
+	in which case the thread's reservation is unchanged. */
+bool thread_set_deadline(int64_t period, int64_t budget)
+{
+	struct thread* cur = thread_current();
+	enum intr_level old_level;
+	int util = 0;
+
+	ASSERT(period >= 0);
+	ASSERT(period == 0 || (0 < budget && budget <= period));
+
+	if (period != 0)
+		util = DIV_ROUND_UP(budget * EDF_UTIL_SCALE, period);
+
+	old_level = intr_disable();
+	if (edf_util - cur->edf_util + util > EDF_UTIL_MAX) {
+		intr_set_level(old_level);
+		return false;
+	}
+	edf_util += util - cur->edf_util;
+	if (cur->edf_period == 0 && period != 0)
+		list_push_back(&edf_list, &cur->edf_list_elem);
+	else if (cur->edf_period != 0 && period == 0)
+		list_remove(&cur->edf_list_elem);
+	cur->edf_period = period;
+	cur->edf_budget = budget;
+	cur->edf_util = util;
+	cur->edf_deadline = timer_ticks() + period;
+	cur->edf_remaining = budget;
+	cur->edf_throttled = false;
+	cur->edf_blocked = false;
+	intr_set_level(old_level);
+
+	thread_preempt();
+	return true;
+}
+
+/* Returns the number of deadlines the current thread has
+	missed. */
+unsigned thread_get_deadline_misses(void)
+{
+	return thread_current()->edf_misses;
 }
 
 /* Returns the current thread's nice value. */
 int thread_get_nice(void)
 {
-	/* Not yet implemented. */
-	return 0;
+	return thread_current()->nice;
 }
 
 /* Returns 100 times the system load average. */
 int thread_get_load_avg(void)
 {
-	/* Not yet implemented. */
-	return 0;
+	enum intr_level old_level = intr_disable();
+	int load = fp_round(fp_mul_int(load_avg, 100));
+	intr_set_level(old_level);
+	return load;
 }
 
 /* Returns 100 times the current thread's recent_cpu value. */
 int thread_get_recent_cpu(void)
 {
-	/* Not yet implemented. */
-	return 0;
+	enum intr_level old_level = intr_disable();
+	int recent = fp_round(fp_mul_int(thread_current()->recent_cpu, 100));
+	intr_set_level(old_level);
+	return recent;
 }
 
-/* Idle thread.  Executes when no other thread is ready to run.
+/* Idle thread of the bootstrap processor.  Executes when no
+	other thread is ready to run.
 
-	The idle thread is initially put on the ready list by
+	The idle thread is initially put on a run queue by
 	thread_start().  It will be scheduled once initially, at which
 	point it initializes idle_thread, "up"s the semaphore passed
 	to it to enable thread_start() to continue, and immediately
 	blocks.  After that, the idle thread never appears in the
-	ready list.  It is returned by next_thread_to_run() as a
-	special case when the ready list is empty. */
+	run queues.  It is returned by next_thread_to_run() as a
+	special case when all of the run queues are empty. */
 static void idle(void* idle_started_ UNUSED)
 {
 	struct semaphore* idle_started = idle_started_;
-	idle_thread = thread_current();
+	cpu_current()->idle_thread = thread_current();
 	sema_up(idle_started);
+	idle_loop();
+}
 
+/* Body of every CPU's idle thread. */
+static void idle_loop(void)
+{
 	for (;;) {
 		/* Let someone else run. */
 		intr_disable();
 		thread_block();
 
-		/* Re-enable interrupts and wait for the next one.
+		/* Nothing else is ready, so stop the periodic tick until
+			the next timer is due, if configured to.  Only the
+			bootstrap processor has that tick, and it may stop only
+			once every CPU idles, because the others read the time
+			from it. */
+		if (cpu_current()->id == 0 && all_cpus_idle())
+			timer_idle_enter();
 
-			The `sti' instruction disables interrupts until the
-			completion of the next instruction, so these two
-			instructions are executed atomically.  This atomicity is
-			important; otherwise, an interrupt could be handled
-			between re-enabling interrupts and waiting for the next
-			one to occur, wasting as much as one clock tick worth of
-			time.
-
-			See [IA32-v2a] "HLT", [IA32-v2b] "STI", and [IA32-v3a]
-			7.11.1 "HLT Instruction". */
-		asm volatile("sti; hlt" : : : "memory");
+		/* Re-enable interrupts and wait for the next one. */
+		intr_halt();
 	}
 }
 
+/* Returns true if no CPU has a thread to run. */
+static bool all_cpus_idle(void)
+{
+	int i;
+
+	ASSERT(intr_get_level() == INTR_OFF);
+
+	for (i = 0; i < cpu_cnt; i++)
+		if (cpus[i].started && !cpu_idle(&cpus[i]))
+			return false;
+	return true;
+}
+
+/* Prepares CPU C, an application processor that smp_start() is
+	about to start, to run threads.  Sets up C's idle thread,
+	which is also the thread that C boots in, and returns the top
+	of its stack, for C to start on. */
+void* thread_prepare_cpu(struct cpu* c)
+{
+	struct thread* t = thread_page_get();
+	char name[16];
+
+	if (t == NULL)
+		PANIC("no memory for cpu %d idle thread", c->id);
+	snprintf(name, sizeof name, "idle%d", c->id);
+	init_thread(t, name, PRI_MIN);
+	t->tid = allocate_tid();
+	t->status = THREAD_RUNNING;
+	t->cpu = c;
+	c->idle_thread = t;
+	c->curr = t;
+	return t->stack;
+}
+
+/* Starts scheduling threads on the current CPU, an application
+	processor prepared by thread_prepare_cpu().  The CPU goes on
+	in its idle thread, which it booted in.  Must be called with
+	interrupts off. */
+void thread_start_ap(void)
+{
+	struct cpu* c = cpu_current();
+
+	ASSERT(intr_get_level() == INTR_OFF);
+	ASSERT(running_thread() == c->idle_thread);
+
+	c->switch_ns = timer_ns();
+	c->started = true;
+	idle_loop();
+}
+
 /* Function used as the basis for a kernel thread. */
 static void kernel_thread(thread_func* function, void* aux)
 {
@@ -407,6 +1052,12 @@ static void kernel_thread(thread_func* function, void* aux)
 	thread_exit(); /* If function() returns, kill the thread. */
 }
 
+/* Returns the CPU we are running on. */
+struct cpu* cpu_current(void)
+{
+	return running_thread()->cpu;
+}
+
 /* Returns the running thread. */
 struct thread* running_thread(void)
 {
@@ -426,6 +1077,12 @@ static bool is_thread(struct thread* t)
 	return t != NULL && t->magic == THREAD_MAGIC;
 }
 
+/* Returns true if T is the idle thread of some CPU. */
+static bool is_idle_thread(const struct thread* t)
+{
+	return t->cpu != NULL && t->cpu->idle_thread == t;
+}
+
 /* Does basic initialization of T as a blocked thread named
 	NAME. */
 static void init_thread(struct thread* t, const char* name, int priority)
@@ -440,7 +1097,11 @@ static void init_thread(struct thread* t, const char* name, int priority)
 	t->status = THREAD_BLOCKED;
 	strlcpy(t->name, name, sizeof t->name);
 	t->stack = (uint8_t*) t + PGSIZE;
-	t->priority = priority;
+	t->priority = t->base_priority = priority;
+	list_init(&t->donors);
+#ifdef USERPROG
+	fd_table_init(&t->fds);
+#endif
 	t->magic = THREAD_MAGIC;
 
 	old_level = intr_disable();
@@ -456,21 +1117,450 @@ static void* alloc_frame(struct thread* t, size_t size)
 	ASSERT(is_thread(t));
 	ASSERT(size % sizeof(uint32_t) == 0);
 
+	/* The page may be recycled, so clear the frame. */
 	t->stack -= size;
+	memset(t->stack, 0, size);
 	return t->stack;
 }
 
-/* Chooses and returns the next thread to be scheduled.  Should
-	return a thread from the run queue, unless the run queue is
-	empty.  (If the running thread can continue running, then it
-	will be in the run queue.)  If the run queue is empty, return
-	idle_thread. */
-static struct thread* next_thread_to_run(void)
+/* Returns the run queue of CPU C. */
+static struct run_queue* cpu_rq(const struct cpu* c)
 {
-	if (list_empty(&ready_list))
-		return idle_thread;
+	return &run_queues[c->id];
+}
+
+/* Adds T to the back of the queue for its priority in the run
+	queue of T's CPU, or, under the completely fair scheduler, to
+	that run queue's CFS tree.  Threads in the
+	earliest-deadline-first class go to its EDF tree instead.  If
+	T's CPU is another one and T should preempt the thread running
+	there, sends that CPU a reschedule interrupt. */
+static void ready_queue_push(struct thread* t)
+{
+	struct run_queue* rq = cpu_rq(t->cpu);
+
+	ASSERT(intr_get_level() == INTR_OFF);
+	ASSERT(PRI_MIN <= t->priority && t->priority <= PRI_MAX);
+
+	if (edf_active(t))
+		rb_insert(&rq->edf, &t->edf_elem);
+	else if (thread_cfs)
+		rb_insert(&rq->cfs, &t->cfs_elem);
+	else {
+		list_push_back(&rq->queues[t->priority], &t->elem);
+		rq->bitmap[t->priority / READY_WORD_BITS] |= 1u << (t->priority % READY_WORD_BITS);
+	}
+	rq->cnt++;
+
+	if (t->cpu != cpu_current() && should_preempt(t->cpu))
+		smp_reschedule(t->cpu);
+}
+
+/* Removes ready thread T from its run queue. */
+static void ready_queue_remove(struct thread* t)
+{
+	struct run_queue* rq = cpu_rq(t->cpu);
+
+	ASSERT(intr_get_level() == INTR_OFF);
+	ASSERT(t->status == THREAD_READY);
+
+	if (edf_active(t))
+		rb_remove(&rq->edf, &t->edf_elem);
+	else if (thread_cfs)
+		rb_remove(&rq->cfs, &t->cfs_elem);
+	else {
+		list_remove(&t->elem);
+		if (list_empty(&rq->queues[t->priority]))
+			rq->bitmap[t->priority / READY_WORD_BITS] &= ~(1u << (t->priority % READY_WORD_BITS));
+	}
+	rq->cnt--;
+}
+
+/* Returns the priority of the highest-priority thread in RQ, or
+	PRI_MIN - 1 if RQ is empty. */
+static int ready_queue_max_priority(const struct run_queue* rq)
+{
+	int i;
+
+	ASSERT(intr_get_level() == INTR_OFF);
+
+	for (i = READY_WORD_CNT - 1; i >= 0; i--)
+		if (rq->bitmap[i] != 0)
+			return i * READY_WORD_BITS + (READY_WORD_BITS - 1 - __builtin_clz(rq->bitmap[i]));
+	return PRI_MIN - 1;
+}
+
+/* Removes and returns the thread at the front of the
+	highest-priority nonempty queue in RQ, or a null pointer if RQ
+	is empty.  Under the completely fair scheduler, removes and
+	returns the ready thread with the least virtual runtime
+	instead.  Either way, a ready thread in the
+	earliest-deadline-first class comes first. */
+static struct thread* ready_queue_pop(struct run_queue* rq)
+{
+	int pri;
+	struct thread* t;
+
+	if (!rb_empty(&rq->edf)) {
+		t = rb_entry(rb_min(&rq->edf), struct thread, edf_elem);
+		rb_remove(&rq->edf, &t->edf_elem);
+		rq->cnt--;
+		return t;
+	}
+
+	if (thread_cfs) {
+		if (rb_empty(&rq->cfs))
+			return NULL;
+		t = rb_entry(rb_min(&rq->cfs), struct thread, cfs_elem);
+		rb_remove(&rq->cfs, &t->cfs_elem);
+		rq->cnt--;
+		return t;
+	}
+
+	pri = ready_queue_max_priority(rq);
+	if (pri < PRI_MIN)
+		return NULL;
+
+	t = list_entry(list_pop_front(&rq->queues[pri]), struct thread, elem);
+	if (list_empty(&rq->queues[pri]))
+		rq->bitmap[pri / READY_WORD_BITS] &= ~(1u << (pri % READY_WORD_BITS));
+	rq->cnt--;
+	return t;
+}
+
+/* Returns true if a thread in C's run queue should preempt the
+	thread running on C.  The idle thread gives way to any ready
+	thread at all. */
+static bool should_preempt(struct cpu* c)
+{
+	struct thread* cur = c->curr;
+	struct run_queue* rq = cpu_rq(c);
+
+	ASSERT(intr_get_level() == INTR_OFF);
+
+	if (!rb_empty(&rq->edf) || edf_active(cur))
+		return edf_should_preempt(cur);
+	else if (thread_cfs)
+		return cfs_should_preempt(cur);
 	else
-		return list_entry(list_pop_front(&ready_list), struct thread, elem);
+		return ready_queue_max_priority(rq) > (is_idle_thread(cur) ? PRI_MIN - 1 : cur->priority);
+}
+
+/* Returns true if C is running its idle thread and has no thread
+	ready to run. */
+static bool cpu_idle(const struct cpu* c)
+{
+	return c->started && c->curr == c->idle_thread && cpu_rq(c)->cnt == 0;
+}
+
+/* Returns the CPU, other than SELF, with the most threads in its
+	run queue, or a null pointer if no other CPU has any. */
+static struct cpu* busiest_cpu(const struct cpu* self)
+{
+	struct cpu* busiest = NULL;
+	int i;
+
+	for (i = 0; i < cpu_cnt; i++) {
+		struct cpu* c = &cpus[i];
+		if (c != self && c->started && cpu_rq(c)->cnt > 0
+			 && (busiest == NULL || cpu_rq(c)->cnt > cpu_rq(busiest)->cnt))
+			busiest = c;
+	}
+	return busiest;
+}
+
+/* Returns the CPU that T, which is waking up, should run on: the
+	CPU it last ran on if that one is idle, otherwise any idle
+	CPU, so that T runs at once, otherwise the CPU it last ran on
+	after all. */
+static struct cpu* wake_cpu(const struct thread* t)
+{
+	int i;
+
+	if (cpu_idle(t->cpu))
+		return t->cpu;
+	for (i = 0; i < cpu_cnt; i++)
+		if (cpu_idle(&cpus[i]))
+			return &cpus[i];
+	return t->cpu;
+}
+
+/* Moves T, which must not be in a run queue, to CPU C, taking
+	its share of the load along.  Virtual runtimes in different
+	run queues advance separately, so T keeps its lead or lag
+	relative to the least in its run queue. */
+static void thread_move(struct thread* t, struct cpu* c)
+{
+	ASSERT(intr_get_level() == INTR_OFF);
+
+	if (t->cpu == c)
+		return;
+	t->vruntime += cpu_rq(c)->cfs_min_vruntime - cpu_rq(t->cpu)->cfs_min_vruntime;
+	if (t->runnable) {
+		cfs_account(cpu_rq(t->cpu), t, -1);
+		cfs_account(cpu_rq(c), t, 1);
+	}
+	t->cpu = c;
+}
+
+/* Changes T's effective priority to PRIORITY, moving T to the
+	matching run queue if it is ready. */
+static void set_effective_priority(struct thread* t, int priority)
+{
+	ASSERT(intr_get_level() == INTR_OFF);
+	ASSERT(PRI_MIN <= priority && priority <= PRI_MAX);
+
+	if (t->status == THREAD_READY && !is_idle_thread(t)) {
+		ready_queue_remove(t);
+		t->priority = priority;
+		ready_queue_push(t);
+	}
+	else
+		t->priority = priority;
+}
+
+/* Recomputes T's effective priority as the maximum of its base
+	priority and the priorities of its donors. */
+static void refresh_priority(struct thread* t)
+{
+	int priority = t->base_priority;
+	struct list_elem* e;
+
+	ASSERT(intr_get_level() == INTR_OFF);
+
+	for (e = list_begin(&t->donors); e != list_end(&t->donors); e = list_next(e)) {
+		struct thread* donor = list_entry(e, struct thread, donor_elem);
+		if (donor->priority > priority)
+			priority = donor->priority;
+	}
+	set_effective_priority(t, priority);
+}
+
+/* Adds T to, or removes it from, the runnable threads of its
+	scheduling group and the load of its CPU, according to RUNNABLE.
+	Does nothing if T is already in the given state.  Must be
+	called with interrupts off. */
+static void sched_set_runnable(struct thread* t, bool runnable)
+{
+	int delta = runnable ? 1 : -1;
+
+	ASSERT(intr_get_level() == INTR_OFF);
+
+	if (t->runnable == runnable || t->group == NULL)
+		return;
+	t->runnable = runnable;
+	t->group->runnable += delta;
+	cfs_account(cpu_rq(t->cpu), t, delta);
+}
+
+/* Adds T, if DELTA is 1, or removes it, if DELTA is -1, from the
+	runnable threads counted in RQ's load. */
+static void cfs_account(struct run_queue* rq, const struct thread* t, int delta)
+{
+	rq->cfs_nr_running += delta;
+	rq->cfs_load += delta * cfs_weights[t->nice - NICE_MIN];
+}
+
+/* Orders threads by virtual runtime. */
+static bool cfs_less(const struct rb_elem* a_, const struct rb_elem* b_, void* aux UNUSED)
+{
+	const struct thread* a = rb_entry(a_, struct thread, cfs_elem);
+	const struct thread* b = rb_entry(b_, struct thread, cfs_elem);
+
+	return a->vruntime < b->vruntime;
+}
+
+/* Returns T's weight: the weight for its niceness, shared among
+	the runnable threads of its group. */
+static long cfs_weight(const struct thread* t)
+{
+	long weight = cfs_weights[t->nice - NICE_MIN];
+
+	if (t->group != NULL && t->group->runnable > 1)
+		weight /= t->group->runnable;
+	return weight > 0 ? weight : 1;
+}
+
+/* Charges T, a running thread, for the CPU time it has used
+	since it was last charged, and advances the cfs_min_vruntime of
+	its run queue.  Must be called with interrupts off. */
+static void cfs_update_curr(struct thread* t)
+{
+	struct run_queue* rq = cpu_rq(t->cpu);
+	int64_t now = timer_clock_us();
+	int64_t min;
+
+	ASSERT(intr_get_level() == INTR_OFF);
+
+	if (now > t->exec_start)
+		t->vruntime += (now - t->exec_start) * CFS_NICE_0_WEIGHT / cfs_weight(t);
+	t->exec_start = now;
+
+	min = t->vruntime;
+	if (!rb_empty(&rq->cfs)) {
+		int64_t leftmost = rb_entry(rb_min(&rq->cfs), struct thread, cfs_elem)->vruntime;
+		if (leftmost < min)
+			min = leftmost;
+	}
+	if (min > rq->cfs_min_vruntime)
+		rq->cfs_min_vruntime = min;
+}
+
+/* Performs the completely fair scheduler's per-tick work for T,
+	the running thread.  Returns true if T has used up its slice
+	and another thread is ready. */
+static bool cfs_tick(struct thread* t)
+{
+	struct run_queue* rq = cpu_rq(t->cpu);
+	long weight = cfs_weights[t->nice - NICE_MIN];
+	long load = rq->cfs_load + (t->runnable ? 0 : weight);
+	int64_t period = CFS_LATENCY;
+	int64_t slice;
+
+	cfs_update_curr(t);
+	if (rb_empty(&rq->cfs))
+		return false;
+
+	/* Stretch the period once slices would get too short. */
+	if (rq->cfs_nr_running > CFS_LATENCY / CFS_MIN_GRANULARITY)
+		period = (int64_t) rq->cfs_nr_running * CFS_MIN_GRANULARITY;
+	slice = period * weight / load;
+	if (slice < CFS_MIN_GRANULARITY)
+		slice = CFS_MIN_GRANULARITY;
+
+	return t->exec_start - t->run_time >= slice;
+}
+
+/* Returns true if the ready thread with the least virtual runtime
+	in the run queue of CUR, a running thread, should preempt CUR:
+	if CUR is idle, or if CUR has received more than
+	CFS_WAKEUP_GRANULARITY more weighted CPU time. */
+static bool cfs_should_preempt(struct thread* cur)
+{
+	struct run_queue* rq = cpu_rq(cur->cpu);
+	struct thread* next;
+
+	ASSERT(intr_get_level() == INTR_OFF);
+
+	if (rb_empty(&rq->cfs))
+		return false;
+	if (is_idle_thread(cur))
+		return true;
+
+	cfs_update_curr(cur);
+	next = rb_entry(rb_min(&rq->cfs), struct thread, cfs_elem);
+	return cur->vruntime - next->vruntime > CFS_WAKEUP_GRANULARITY;
+}
+
+/* Returns true if T is in the earliest-deadline-first class and
+	has budget left in its current period. */
+static bool edf_active(const struct thread* t)
+{
+	return t->edf_period != 0 && !t->edf_throttled;
+}
+
+/* Orders threads by deadline. */
+static bool edf_less(const struct rb_elem* a_, const struct rb_elem* b_, void* aux UNUSED)
+{
+	const struct thread* a = rb_entry(a_, struct thread, edf_elem);
+	const struct thread* b = rb_entry(b_, struct thread, edf_elem);
+
+	return a->edf_deadline < b->edf_deadline;
+}
+
+/* Charges a tick to T, the running thread, which must be in the
+	earliest-deadline-first class.  Returns true if T has used up
+	its budget, in which case T is throttled until its next
+	period. */
+static bool edf_tick(struct thread* t)
+{
+	if (--t->edf_remaining > 0)
+		return false;
+
+	t->edf_throttled = true;
+	t->edf_throttles++;
+	edf_throttles++;
+	return true;
+}
+
+/* Starts a new period for each thread in the earliest-deadline-
+	first class whose period has ended by NOW, counting a missed
+	deadline if it had not blocked since the period began, and
+	refills its budget.  Runs in the timer interrupt handler. */
+static void edf_release(int64_t now)
+{
+	struct list_elem* e;
+	bool released = false;
+
+	ASSERT(intr_get_level() == INTR_OFF);
+
+	for (e = list_begin(&edf_list); e != list_end(&edf_list); e = list_next(e)) {
+		struct thread* t = list_entry(e, struct thread, edf_list_elem);
+		bool ready = t->status == THREAD_READY;
+
+		if (now < t->edf_deadline)
+			continue;
+		if (!t->edf_blocked) {
+			t->edf_misses++;
+			edf_misses++;
+		}
+
+		/* The deadline is a key of the EDF run queue. */
+		if (ready)
+			ready_queue_remove(t);
+		t->edf_deadline += ((now - t->edf_deadline) / t->edf_period + 1) * t->edf_period;
+		t->edf_remaining = t->edf_budget;
+		t->edf_throttled = false;
+		t->edf_blocked = t->status == THREAD_BLOCKED;
+		if (ready)
+			ready_queue_push(t);
+		released = true;
+	}
+
+	if (released)
+		thread_preempt();
+}
+
+/* Returns true if the ready thread with the earliest deadline in
+	the run queue of CUR, a running thread, should preempt CUR: if
+	CUR is not in the earliest-deadline-first class, or if its
+	deadline is later. */
+static bool edf_should_preempt(struct thread* cur)
+{
+	struct run_queue* rq = cpu_rq(cur->cpu);
+	struct thread* next;
+
+	ASSERT(intr_get_level() == INTR_OFF);
+
+	if (rb_empty(&rq->edf))
+		return false;
+	if (!edf_active(cur))
+		return true;
+
+	next = rb_entry(rb_min(&rq->edf), struct thread, edf_elem);
+	return next->edf_deadline < cur->edf_deadline;
+}
+
+/* Chooses and returns the next thread to be scheduled on the
+	current CPU.  Should return a thread from the CPU's run queue,
+	unless it is empty, in which case it takes one from the run
+	queue of the busiest other CPU.  (If the running thread can
+	continue running, then it will be in a run queue.)  If every
+	run queue is empty, return the CPU's idle_thread. */
+static struct thread* next_thread_to_run(void)
+{
+	struct cpu* c = cpu_current();
+	struct thread* t = ready_queue_pop(cpu_rq(c));
+
+	if (t == NULL) {
+		struct cpu* busiest = busiest_cpu(c);
+		if (busiest != NULL) {
+			t = ready_queue_pop(cpu_rq(busiest));
+			thread_move(t, c);
+			steals++;
+		}
+	}
+	return t != NULL ? t : c->idle_thread;
 }
 
 /* Completes a thread switch by activating the new thread's page
@@ -498,8 +1588,19 @@ void thread_schedule_tail(struct thread* prev)
 	/* Mark us as running. */
 	cur->status = THREAD_RUNNING;
 
+	/* Account for the wait since we were unblocked, if we were. */
+	cur->run_time = cur->exec_start = timer_clock_us();
+	if (cur->wake_time != 0 && !is_idle_thread(cur)) {
+		int64_t latency = cur->run_time - cur->wake_time;
+#ifdef SCHED_STATS
+		sched_hist_add(cur->stats.latency, latency);
+#endif
+		sched_hist_add(sched_stats.latency, latency);
+	}
+	cur->wake_time = 0;
+
 	/* Start new time slice. */
-	thread_ticks = 0;
+	cpu_current()->thread_ticks = 0;
 
 #ifdef USERPROG
 	/* Activate the new address space. */
@@ -513,7 +1614,7 @@ void thread_schedule_tail(struct thread* prev)
 		palloc().) */
 	if (prev != NULL && prev->status == THREAD_DYING && prev != initial_thread) {
 		ASSERT(prev != cur);
-		palloc_free_page(prev);
+		thread_page_free(prev);
 	}
 }
 
@@ -526,6 +1627,7 @@ void thread_schedule_tail(struct thread* prev)
 	has completed. */
 static void schedule(void)
 {
+	struct cpu* c = cpu_current();
 	struct thread* cur = running_thread();
 	struct thread* next = next_thread_to_run();
 	struct thread* prev = NULL;
@@ -533,12 +1635,101 @@ static void schedule(void)
 	ASSERT(intr_get_level() == INTR_OFF);
 	ASSERT(cur->status != THREAD_RUNNING);
 	ASSERT(is_thread(next));
+	ASSERT(next->cpu == c);
 
-	if (cur != next)
+	if (cur->status == THREAD_BLOCKED) {
+		cur->edf_blocked = true;
+		if (thread_cfs && !is_idle_thread(cur))
+			cfs_update_curr(cur);
+		sched_set_runnable(cur, false);
+	}
+	c->curr = next;
+	if (cur != next) {
+		TRACE(TRACE_SWITCH, next->tid, cur->status);
+		sched_charge_time(cur);
+		if (!is_idle_thread(cur))
+			sched_account_switch(cur);
 		prev = switch_threads(cur, next);
+	}
 	thread_schedule_tail(prev);
 }
 
+/* Records the end of the run slice of CUR, which is about to
+	be switched away from.  The switch is voluntary if CUR is
+	blocking or exiting, involuntary if CUR is still ready to run,
+	as after preemption. */
+static void sched_account_switch(struct thread* cur)
+{
+	int64_t slice = timer_clock_us() - cur->run_time;
+
+	sched_hist_add(sched_stats.slice, slice);
+	if (cur->status == THREAD_READY)
+		sched_stats.involuntary++;
+	else
+		sched_stats.voluntary++;
+#ifdef SCHED_STATS
+	sched_hist_add(cur->stats.slice, slice);
+	if (cur->status == THREAD_READY)
+		cur->stats.involuntary++;
+	else
+		cur->stats.voluntary++;
+#endif
+}
+
+/* Charges the time since the last thread switch to CUR, which
+	is about to be switched away from, as idle, kernel, or user
+	time, as thread_tick() does with ticks. */
+static void sched_charge_time(struct thread* cur)
+{
+	struct cpu* c = cpu_current();
+	int64_t now = timer_ns();
+	int64_t ns = now - c->switch_ns;
+
+	c->switch_ns = now;
+	if (is_idle_thread(cur))
+		idle_ns += ns;
+#ifdef USERPROG
+	else if (cur->pagedir != NULL)
+		user_ns += ns;
+#endif
+	else
+		kernel_ns += ns;
+}
+
+/* Returns a page for a new thread, from the page cache if
+	possible, or a null pointer if none is available.  The page's
+	contents are arbitrary. */
+static struct thread* thread_page_get(void)
+{
+	struct thread* t = NULL;
+	enum intr_level old_level;
+
+	old_level = intr_disable();
+	if (page_cache_cnt > 0) {
+		t = page_cache[--page_cache_cnt];
+		page_cache_hits++;
+	}
+	else
+		page_cache_misses++;
+	intr_set_level(old_level);
+
+	return t != NULL ? t : palloc_get_page(0);
+}
+
+/* Frees the page of dead thread T, keeping it in the page cache
+	if there is room.  Must be called with interrupts off. */
+static void thread_page_free(struct thread* t)
+{
+	ASSERT(intr_get_level() == INTR_OFF);
+
+	/* Keep a recycled page from passing as a live thread. */
+	t->magic = 0;
+	if (page_cache_cnt < PAGE_CACHE_MAX)
+		page_cache[page_cache_cnt++] = t;
+	else
+		palloc_free_page(t);
+}
+
 /* Returns a tid to use for a new thread. */
 static tid_t allocate_tid(void)
 {
@@ -3,8 +3,13 @@
 
 #include <debug.h>
 #include <list.h>
+#include <rbtree.h>
 #include <stdint.h>
+#include "threads/fixed-point.h"
 #include "threads/synch.h"
+#ifdef USERPROG
+#include "userprog/fdtable.h"
+#endif
 
 /* States in a thread's life cycle. */
 enum thread_status {
@@ -24,6 +29,29 @@ typedef int tid_t;
 #define PRI_DEFAULT 31 /* Default priority. */
 #define PRI_MAX	  63 /* Highest priority. */
 
+/* Thread niceness, used by the multi-level feedback queue
+	scheduler. */
+#define NICE_MIN	  -20 /* Nicest to other threads. */
+#define NICE_DEFAULT 0	 /* Default niceness. */
+#define NICE_MAX	  20	 /* Least nice to other threads. */
+
+/* Scheduling statistics, kept for the system as a whole and, in
+	kernels built with -DSCHED_STATS, for each thread.  They are
+	not kept per thread otherwise, because struct thread shares
+	its page with the kernel stack.  Each histogram is a log2 histogram of
+	microseconds: bucket 0 counts values under 1 us, and bucket
+	I > 0 counts values from 2**(I-1) us up to 2**I us, except
+	that the last bucket also counts everything longer. */
+#define SCHED_HIST_BUCKETS 20
+struct sched_stats {
+	unsigned latency[SCHED_HIST_BUCKETS]; /* Wakeup-to-run latency. */
+	unsigned slice[SCHED_HIST_BUCKETS];	  /* Length of run slices. */
+	unsigned voluntary;						  /* Switches away by blocking. */
+	unsigned involuntary;					  /* Switches away while ready. */
+};
+
+struct sched_group;
+
 /* A kernel thread or user process.
 
 	Each thread structure is stored in its own 4 kB page.  The
@@ -82,10 +110,7 @@ typedef int tid_t;
 	ready state is on the run queue, whereas only a thread in the
 	blocked state is on a semaphore wait list. */
 
- struct file_list {
- 	struct file** files;
- 	int look_from;
-};
+struct cpu;
 
 struct thread {
 	/* Owned by thread.c. */
@@ -93,13 +118,49 @@ struct thread {
 	enum thread_status status; /* Thread state. */
 	char name[16];					/* Name (for debugging purposes). */
 	uint8_t* stack;				/* Saved stack pointer. */
-	int priority;					/* Priority. */
+	int priority;					/* Effective priority, including donations. */
+	int base_priority;			/* Priority set by thread_set_priority(). */
+	struct cpu* cpu;				/* CPU running it, or whose run queue it is in. */
 	struct list_elem allelem;	/* List element for all threads list. */
 
+	/* Priority donation, shared between thread.c and synch.c. */
+	struct lock* waiting_lock;	/* Lock this thread is blocked on, if any. */
+	struct list donors;			/* Threads waiting on locks we hold. */
+	struct list_elem donor_elem; /* Element in holder's `donors' list. */
+
+	/* Multi-level feedback queue scheduler, owned by thread.c. */
+	int nice;				/* Niceness, NICE_MIN...NICE_MAX. */
+	fixed_t recent_cpu;	/* Recent CPU time received. */
+
+	/* Completely fair scheduler, owned by thread.c. */
+	int64_t vruntime;				/* Weighted CPU time received, in us. */
+	int64_t exec_start;			/* When CPU time was last charged, in us. */
+	bool runnable;					/* Counted in our group as runnable? */
+	struct sched_group* group;	/* Group sharing the CPU as one. */
+	struct rb_elem cfs_elem;	/* Element in the CFS run queue. */
+
+	/* Earliest-deadline-first class, owned by thread.c. */
+	int64_t edf_period;				/* Period in ticks, 0 if not in the class. */
+	int64_t edf_budget;				/* CPU time reserved per period, in ticks. */
+	int64_t edf_deadline;			/* Tick at which the current period ends. */
+	int64_t edf_remaining;			/* Budget left in the current period. */
+	int edf_util;						/* Share of the CPU reserved. */
+	bool edf_throttled;				/* Budget used up for this period? */
+	bool edf_blocked;					/* Blocked since this period began? */
+	unsigned edf_misses;				/* Periods that ended still runnable. */
+	unsigned edf_throttles;			/* Periods whose budget ran out. */
+	struct rb_elem edf_elem;		/* Element in the EDF run queue. */
+	struct list_elem edf_list_elem; /* Element in the list of EDF threads. */
+
+	/* Scheduling statistics, owned by thread.c. */
+#ifdef SCHED_STATS
+	struct sched_stats stats;
+#endif
+	int64_t wake_time; /* When last unblocked, 0 once running. */
+	int64_t run_time;	 /* When last switched to. */
+
 	/* Shared between thread.c and synch.c. */
 	struct list_elem elem; /* List element. */
-	int tic_run_again;
-	struct list_elem sleep_list_elem;
 
 	struct parent_child *pc;
 	struct list children_list;
@@ -109,11 +170,13 @@ struct thread {
 
 	int tid_wait_child;
 	struct semaphore process_wait_semaphore;
-	int64_t wakeup_ticks;
 #ifdef USERPROG
 	/* Owned by userprog/process.c. */
 	uint32_t* pagedir; /* Page directory. */
-	struct file *fd_list[130];
+	struct fd_table fds; /* Open files. */
+
+	/* Owned by userprog/syscall.c. */
+	struct syscall_stat* syscall_stats; /* Per-call statistics, or null. */
 #endif
 	//struct thread_data thread_data;
 	/* Owned by thread.c. */
@@ -143,10 +206,18 @@ struct thread {
 	Controlled by kernel command-line option "-o mlfqs". */
 extern bool thread_mlfqs;
 
+/* If true, use the completely fair scheduler instead of either
+	of the above.  Controlled by kernel command-line option
+	"-cfs". */
+extern bool thread_cfs;
+
 void thread_init(void);
 void thread_start(void);
+void* thread_prepare_cpu(struct cpu*);
+void thread_start_ap(void) NO_RETURN;
 
 void thread_tick(void);
+void thread_ticks_skipped(int64_t cnt);
 void thread_print_stats(void);
 
 typedef void thread_func(void* aux);
@@ -154,6 +225,7 @@ tid_t thread_create(const char* name, int priority, thread_func*, void*);
 
 void thread_block(void);
 void thread_unblock(struct thread*);
+void thread_preempt(void);
 
 struct thread* thread_current(void);
 tid_t thread_tid(void);
@@ -168,9 +240,14 @@ void thread_foreach(thread_action_func*, void*);
 
 int thread_get_priority(void);
 void thread_set_priority(int);
+void thread_donate_priority(struct thread* donor);
+void thread_remove_donors(const struct lock*);
 
 int thread_get_nice(void);
 void thread_set_nice(int);
+bool thread_new_sched_group(void);
+bool thread_set_deadline(int64_t period, int64_t budget);
+unsigned thread_get_deadline_misses(void);
 int thread_get_recent_cpu(void);
 int thread_get_load_avg(void);
 
@@ -0,0 +1,130 @@
+#include "threads/trace.h"
+
+#include "devices/serial.h"
+#include "devices/timer.h"
+#include "threads/cpu.h"
+#include "threads/interrupt.h"
+#include "threads/palloc.h"
+#include "threads/thread.h"
+#include "threads/vaddr.h"
+
+#include <debug.h>
+#include <round.h>
+#include <stdio.h>
+
+/* Trace buffers.
+
+	Each CPU records events into its own ring of TRACE_RING_CNT
+	records, allocated once by trace_start(), so recording never
+	allocates memory or takes a lock.  A writer claims a slot by
+	atomically incrementing the ring's head, which also serves an
+	interrupt handler that records an event between a thread's
+	claim and its write.  When the ring is full the oldest
+	records are overwritten.
+
+	trace_dump() stops tracing and writes each CPU's records to
+	the serial port, oldest first, as a text header line
+		TRACE <cpu> <record count>
+	followed by the records in binary, little-endian, in the
+	layout of struct trace_record, and a new-line.  In the dump,
+	`time' is in nanoseconds since the CPU's oldest record.  The
+	header is preceded by a line
+		TRACE-THREAD <tid> <name>
+	for each live thread.  utils/pintos-trace turns a dump into a
+	text timeline. */
+#define TRACE_RING_CNT 4096 /* Records per CPU. */
+#define TRACE_RING_PAGES DIV_ROUND_UP(TRACE_RING_CNT * sizeof(struct trace_record), PGSIZE)
+
+/* One recorded event.  24 bytes. */
+struct trace_record {
+	uint64_t time;	  /* TSC when recorded. */
+	int32_t tid;	  /* Running thread. */
+	uint16_t event;  /* A member of enum trace_event. */
+	uint16_t cpu;	  /* CPU that recorded the event. */
+	uint32_t arg0;	  /* Event-specific arguments. */
+	uint32_t arg1;
+};
+
+bool trace_enabled;
+
+static void print_thread(struct thread*, void* aux);
+
+/* Allocates the trace buffers and starts tracing.  Must be called
+	after palloc_init(). */
+void trace_start(void)
+{
+	int i;
+
+	for (i = 0; i < cpu_cnt; i++) {
+		cpus[i].trace_ring = palloc_get_multiple(PAL_ASSERT, TRACE_RING_PAGES);
+		cpus[i].trace_head = 0;
+	}
+	trace_enabled = true;
+}
+
+/* Records EVENT with arguments ARG0 and ARG1 in the running CPU's
+	trace buffer.  Use the TRACE macro instead of calling this
+	directly. */
+void trace_record(enum trace_event event, uint32_t arg0, uint32_t arg1)
+{
+	struct cpu* c = cpu_current();
+	unsigned head = __atomic_fetch_add(&c->trace_head, 1, __ATOMIC_RELAXED);
+	struct trace_record* r = &c->trace_ring[head % TRACE_RING_CNT];
+
+	/* Find the running thread at the base of our stack page, as
+		running_thread() does.  thread_current() would assert that
+		it is THREAD_RUNNING, which is not true inside schedule(). */
+	struct thread* t = pg_round_down(&head);
+
+	r->time = rdtsc();
+	r->tid = t->tid;
+	r->event = event;
+	r->cpu = c->id;
+	r->arg0 = arg0;
+	r->arg1 = arg1;
+}
+
+/* Stops tracing and writes the trace buffers to the serial port,
+	if tracing was started, in the format described at the top of
+	this file. */
+void trace_dump(void)
+{
+	enum intr_level old_level;
+	int i;
+
+	if (!trace_enabled)
+		return;
+	trace_enabled = false;
+
+	old_level = intr_disable();
+	thread_foreach(print_thread, NULL);
+	intr_set_level(old_level);
+
+	for (i = 0; i < cpu_cnt; i++) {
+		struct cpu* c = &cpus[i];
+		unsigned cnt = c->trace_head < TRACE_RING_CNT ? c->trace_head : TRACE_RING_CNT;
+		unsigned first = c->trace_head - cnt;
+		uint64_t start = cnt > 0 ? c->trace_ring[first % TRACE_RING_CNT].time : 0;
+		unsigned j;
+
+		printf("Trace: cpu %d: %u events, %u overwritten\n", c->id, c->trace_head, first);
+		printf("TRACE %d %u\n", c->id, cnt);
+		for (j = first; j != c->trace_head; j++) {
+			struct trace_record* r = &c->trace_ring[j % TRACE_RING_CNT];
+			const uint8_t* p = (const uint8_t*) r;
+			size_t k;
+
+			/* The TSC was calibrated after tracing started, so
+				convert to time only now. */
+			r->time = timer_cycles_to_ns(r->time - start);
+			for (k = 0; k < sizeof *r; k++) serial_putc(p[k]);
+		}
+		printf("\n");
+	}
+}
+
+/* Prints T's tid and name for trace_dump(). */
+static void print_thread(struct thread* t, void* aux UNUSED)
+{
+	printf("TRACE-THREAD %d %s\n", t->tid, t->name);
+}
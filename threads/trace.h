@@ -0,0 +1,42 @@
+#ifndef THREADS_TRACE_H
+#define THREADS_TRACE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Static tracepoints.
+
+	TRACE (EVENT, ARG0, ARG1) records EVENT, with two 32-bit
+	arguments whose meaning depends on the event, in the running
+	CPU's trace buffer.  While tracing is off a tracepoint costs
+	one load and one branch that is predicted not taken, so
+	tracepoints may be left in hot paths.  Tracing is turned on
+	by kernel command-line option "-trace". */
+#define TRACE(EVENT, ARG0, ARG1)                                    \
+	do {                                                             \
+		if (__builtin_expect(trace_enabled, 0))                       \
+			trace_record(EVENT, (uint32_t) (ARG0), (uint32_t) (ARG1)); \
+	} while (0)
+
+/* Traced events.  The values are part of the dump format read by
+	utils/pintos-trace, so add new events at the end. */
+enum trace_event {
+	TRACE_SWITCH,			/* Context switch: next tid, previous status. */
+	TRACE_BLOCK,			/* Thread blocks: caller. */
+	TRACE_UNBLOCK,			/* Thread wakes another: its tid, caller. */
+	TRACE_SYSCALL_ENTER, /* System call: number. */
+	TRACE_SYSCALL_EXIT,	/* System call return: number, result. */
+	TRACE_BLOCK_READ,		/* Sector read: sector, device type. */
+	TRACE_BLOCK_WRITE,	/* Sector write: sector, device type. */
+	TRACE_PAGE_FAULT,		/* Page fault: address, eip. */
+	TRACE_EVENT_CNT
+};
+
+/* Are tracepoints recording?  Set by trace_start(). */
+extern bool trace_enabled;
+
+void trace_start(void);
+void trace_record(enum trace_event, uint32_t arg0, uint32_t arg1);
+void trace_dump(void);
+
+#endif /* threads/trace.h */
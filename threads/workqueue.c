@@ -0,0 +1,277 @@
+#include "threads/workqueue.h"
+
+#include "devices/timer.h"
+#include "threads/interrupt.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+
+#include <debug.h>
+#include <inttypes.h>
+#include <stdio.h>
+
+/* Deferred work.
+
+	Subsystems queue work items that need not finish before the
+	current operation returns, such as freeing memory, on a
+	workqueue.  A small pool of worker threads, shared by all
+	workqueues, runs the items.  Each workqueue has a priority: a
+	worker always takes the oldest item from the highest-priority
+	nonempty queue and runs it at that queue's priority.
+
+	Workqueues are protected by disabling interrupts rather than
+	by a lock, so work may be queued and cancelled from interrupt
+	handlers. */
+
+/* Number of worker threads. */
+#define WORKER_CNT 2
+
+/* Queue for work that has no queue of its own. */
+struct workqueue system_workqueue;
+
+/* All workqueues. */
+static struct list workqueues;
+
+/* Upped once for each item queued, to wake a worker. */
+static struct semaphore work_available;
+
+static void worker(void* aux);
+static struct work* work_dequeue(struct workqueue**);
+static void wake_flushers(struct workqueue*);
+
+/* Initializes the workqueue system and starts the worker
+	threads.  Must be called after thread_start(). */
+void workqueue_init(void)
+{
+	int i;
+
+	list_init(&workqueues);
+	sema_init(&work_available, 0);
+	workqueue_setup(&system_workqueue, "system", PRI_DEFAULT);
+
+	for (i = 0; i < WORKER_CNT; i++) {
+		char name[16];
+		snprintf(name, sizeof name, "worker %d", i);
+		thread_create(name, PRI_MAX, worker, NULL);
+	}
+}
+
+/* Initializes WQ as an empty workqueue named NAME whose items run
+	at PRIORITY.  NAME must remain valid as long as the kernel
+	runs. */
+void workqueue_setup(struct workqueue* wq, const char* name, int priority)
+{
+	enum intr_level old_level;
+
+	ASSERT(wq != NULL);
+	ASSERT(name != NULL);
+	ASSERT(PRI_MIN <= priority && priority <= PRI_MAX);
+
+	wq->name = name;
+	wq->priority = priority;
+	list_init(&wq->items);
+	wq->running = 0;
+	list_init(&wq->flushers);
+	wq->depth = wq->max_depth = 0;
+	wq->completed = wq->cancelled = 0;
+	wq->latency_total = wq->latency_max = 0;
+
+	old_level = intr_disable();
+	list_push_back(&workqueues, &wq->elem);
+	intr_set_level(old_level);
+}
+
+/* Waits until WQ has no pending or running items.  Items queued
+	while we wait are waited for too.
+
+	This function may sleep, so it must not be called within an
+	interrupt handler, nor by a work item on WQ. */
+void workqueue_flush(struct workqueue* wq)
+{
+	enum intr_level old_level;
+
+	ASSERT(wq != NULL);
+	ASSERT(!intr_context());
+
+	old_level = intr_disable();
+	while (!list_empty(&wq->items) || wq->running > 0) {
+		list_push_back(&wq->flushers, &thread_current()->elem);
+		thread_block();
+	}
+	intr_set_level(old_level);
+}
+
+/* Prints workqueue statistics. */
+void workqueue_print_stats(void)
+{
+	struct list_elem* e;
+
+	for (e = list_begin(&workqueues); e != list_end(&workqueues); e = list_next(e)) {
+		struct workqueue* wq = list_entry(e, struct workqueue, elem);
+		printf(
+			 "Workqueue: %s: %u completed, %u cancelled, %u pending (max %u), "
+			 "latency %" PRId64 " us total (max %" PRId64 ")\n",
+			 wq->name,
+			 wq->completed,
+			 wq->cancelled,
+			 wq->depth,
+			 wq->max_depth,
+			 wq->latency_total,
+			 wq->latency_max);
+	}
+}
+
+/* Initializes WORK to call FUNC, passing AUX, when it runs.  The
+	item does not run until passed to work_queue(). */
+void work_setup(struct work* work, work_func* func, void* aux)
+{
+	ASSERT(work != NULL);
+	ASSERT(func != NULL);
+
+	work->func = func;
+	work->aux = aux;
+	work->queue = NULL;
+}
+
+/* Queues WORK to run on WQ.  Returns true if successful, false if
+	WORK was already pending, in which case it still runs only
+	once.
+
+	May be called from an interrupt handler. */
+bool work_queue(struct workqueue* wq, struct work* work)
+{
+	enum intr_level old_level;
+	bool queued;
+
+	ASSERT(wq != NULL);
+	ASSERT(work != NULL);
+
+	old_level = intr_disable();
+	queued = work->queue == NULL;
+	if (queued) {
+		work->queue = wq;
+		work->queue_time = timer_clock_us();
+		list_push_back(&wq->items, &work->elem);
+		if (++wq->depth > wq->max_depth)
+			wq->max_depth = wq->depth;
+		sema_up(&work_available);
+	}
+	intr_set_level(old_level);
+
+	if (old_level == INTR_ON)
+		thread_preempt();
+	return queued;
+}
+
+/* Removes WORK from its queue, if it is pending.  Returns true if
+	WORK was pending, false if it was not queued or had already
+	started to run.  Does not wait for a running item to finish.
+
+	May be called from an interrupt handler. */
+bool work_cancel(struct work* work)
+{
+	enum intr_level old_level;
+	bool cancelled;
+
+	ASSERT(work != NULL);
+
+	old_level = intr_disable();
+	cancelled = work->queue != NULL;
+	if (cancelled) {
+		struct workqueue* wq = work->queue;
+		list_remove(&work->elem);
+		work->queue = NULL;
+		wq->depth--;
+		wq->cancelled++;
+		wake_flushers(wq);
+	}
+	intr_set_level(old_level);
+
+	return cancelled;
+}
+
+/* Returns true if WORK is queued and has not yet started to
+	run. */
+bool work_pending(const struct work* work)
+{
+	ASSERT(work != NULL);
+
+	return work->queue != NULL;
+}
+
+/* Worker thread.  Runs work items forever.
+
+	A worker waits for work at PRI_MAX, so that it picks up new
+	work at once whatever the priority of the threads running at
+	the time, and then drops to the priority of the item's
+	queue to run it. */
+static void worker(void* aux UNUSED)
+{
+	for (;;) {
+		struct workqueue* wq;
+		struct work* work;
+		enum intr_level old_level;
+
+		thread_set_priority(PRI_MAX);
+		sema_down(&work_available);
+		work = work_dequeue(&wq);
+		if (work == NULL) {
+			/* The item was cancelled. */
+			continue;
+		}
+
+		thread_set_priority(wq->priority);
+		work->func(work, work->aux);
+
+		old_level = intr_disable();
+		wq->running--;
+		wq->completed++;
+		wake_flushers(wq);
+		intr_set_level(old_level);
+	}
+}
+
+/* Removes and returns the oldest item on the highest-priority
+	nonempty workqueue, or a null pointer if all are empty.  Stores
+	the item's queue, which counts it as running, into *WQ. */
+static struct work* work_dequeue(struct workqueue** wq)
+{
+	struct workqueue* best = NULL;
+	struct work* work = NULL;
+	struct list_elem* e;
+	enum intr_level old_level;
+
+	old_level = intr_disable();
+	for (e = list_begin(&workqueues); e != list_end(&workqueues); e = list_next(e)) {
+		struct workqueue* q = list_entry(e, struct workqueue, elem);
+		if (!list_empty(&q->items) && (best == NULL || q->priority > best->priority))
+			best = q;
+	}
+	if (best != NULL) {
+		int64_t latency;
+
+		work = list_entry(list_pop_front(&best->items), struct work, elem);
+		work->queue = NULL;
+		*wq = best;
+		best->depth--;
+		best->running++;
+		latency = timer_clock_us() - work->queue_time;
+		best->latency_total += latency;
+		if (latency > best->latency_max)
+			best->latency_max = latency;
+	}
+	intr_set_level(old_level);
+
+	return work;
+}
+
+/* Wakes the threads waiting in workqueue_flush() for WQ, if it
+	has become idle.  Must be called with interrupts off. */
+static void wake_flushers(struct workqueue* wq)
+{
+	ASSERT(intr_get_level() == INTR_OFF);
+
+	if (!list_empty(&wq->items) || wq->running > 0)
+		return;
+	while (!list_empty(&wq->flushers))
+		thread_unblock(list_entry(list_pop_front(&wq->flushers), struct thread, elem));
+}
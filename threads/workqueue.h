@@ -0,0 +1,57 @@
+#ifndef THREADS_WORKQUEUE_H
+#define THREADS_WORKQUEUE_H
+
+#include <list.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+struct work;
+
+/* Function that performs a work item.  It runs in a kernel worker
+	thread, so unlike a timer function it may sleep. */
+typedef void work_func(struct work*, void* aux);
+
+/* A deferred work item.  Owned by the caller, but its members are
+	managed by workqueue.c.  The item may be queued again, or freed,
+	once its function has started running. */
+struct work {
+	work_func* func;			  /* Function to call. */
+	void* aux;					  /* Auxiliary data for FUNC. */
+	struct workqueue* queue;  /* Queue it is pending on, if any. */
+	int64_t queue_time;		  /* When queued, in us. */
+	struct list_elem elem;	  /* Element in the queue's `items'. */
+};
+
+/* A queue of work items, run in FIFO order by the shared pool
+	of worker threads at the queue's priority. */
+struct workqueue {
+	const char* name;			  /* Name, for statistics. */
+	int priority;				  /* Priority at which items run. */
+	struct list items;		  /* Pending work items. */
+	unsigned running;			  /* Items currently running. */
+	struct list flushers;	  /* Threads in workqueue_flush(). */
+	struct list_elem elem;	  /* Element in the list of queues. */
+
+	/* Statistics. */
+	unsigned depth;			  /* Number of pending items. */
+	unsigned max_depth;		  /* Largest number of pending items. */
+	unsigned completed;		  /* Items run to completion. */
+	unsigned cancelled;		  /* Items cancelled while pending. */
+	int64_t latency_total;	  /* Total time from queueing to start, in us. */
+	int64_t latency_max;		  /* Longest time from queueing to start, in us. */
+};
+
+/* Queue for work that has no queue of its own. */
+extern struct workqueue system_workqueue;
+
+void workqueue_init(void);
+void workqueue_setup(struct workqueue*, const char* name, int priority);
+void workqueue_flush(struct workqueue*);
+void workqueue_print_stats(void);
+
+void work_setup(struct work*, work_func*, void* aux);
+bool work_queue(struct workqueue*, struct work*);
+bool work_cancel(struct work*);
+bool work_pending(const struct work*);
+
+#endif /* threads/workqueue.h */
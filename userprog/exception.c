@@ -1,7 +1,10 @@
 #include "userprog/exception.h"
 
+#include "threads/flags.h"
 #include "threads/interrupt.h"
 #include "threads/thread.h"
+#include "threads/trace.h"
+#include "threads/vaddr.h"
 #include "userprog/gdt.h"
 #include "userprog/syscall.h"
 
@@ -11,8 +14,19 @@
 /* Number of page faults processed. */
 static long long page_fault_cnt;
 
+/* An entry in the exception fixup table, emitted by
+	EXCEPTION_FIXUP. */
+struct exception_fixup {
+	uintptr_t insn;  /* Instruction that may fault. */
+	uintptr_t fixup; /* Where to resume if it does. */
+};
+
+/* The exception fixup table, collected by the linker script. */
+extern const struct exception_fixup _start_ex_table[], _end_ex_table[];
+
 static void kill(struct intr_frame*);
 static void page_fault(struct intr_frame*);
+static bool fixup_exception(struct intr_frame*);
 
 /* Registers handlers for interrupts that can be caused by user
 	programs.
@@ -136,10 +150,15 @@ static void page_fault(struct intr_frame* f)
 		[IA32-v3a] 5.15 "Interrupt 14--Page Fault Exception
 		(#PF)". */
 	asm("movl %%cr2, %0" : "=r"(fault_addr));
+	TRACE(TRACE_PAGE_FAULT, fault_addr, f->eip);
 
-	/* Turn interrupts back on (they were only off so that we could
-		be assured of reading CR2 before it changed). */
-	intr_enable();
+	/* Turn interrupts back on if the faulting code had them on
+		(they were only off so that we could be assured of reading
+		CR2 before it changed).  Kernel code that faulted with them
+		off still holds the big kernel lock, which turning them on
+		would release. */
+	if (f->eflags & FLAG_IF)
+		intr_enable();
 
 	/* Count page faults. */
 	page_fault_cnt++;
@@ -149,6 +168,12 @@ static void page_fault(struct intr_frame* f)
 	write = (f->error_code & PF_W) != 0;
 	user = (f->error_code & PF_U) != 0;
 
+	/* A kernel access to a user address from one of the user
+		memory copy routines means that a system call was passed a
+		bad pointer.  Let the routine report failure. */
+	if (!user && is_user_vaddr(fault_addr) && fixup_exception(f))
+		return;
+
 	/* To implement virtual memory, delete the rest of the function
 		body, and replace it with code that brings in the page to
 		which fault_addr refers. */
@@ -164,3 +189,18 @@ static void page_fault(struct intr_frame* f)
 	kill(f);
 	}
 }
+
+/* If F's faulting instruction has an entry in the exception
+	fixup table, makes F resume at its fixup and returns true.
+	Otherwise, returns false. */
+static bool fixup_exception(struct intr_frame* f)
+{
+	const struct exception_fixup* e;
+
+	for (e = _start_ex_table; e < _end_ex_table; e++)
+		if (e->insn == (uintptr_t) f->eip) {
+			f->eip = (void (*)(void)) e->fixup;
+			return true;
+		}
+	return false;
+}
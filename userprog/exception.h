@@ -6,6 +6,17 @@
 #define PF_W 0x2 /* 0: read, 1: write. */
 #define PF_U 0x4 /* 0: kernel, 1: user process. */
 
+/* Expands to inline assembly that adds an entry to the exception
+	fixup table: if the instruction at label INSN page faults in
+	kernel mode on a user address, page_fault() resumes execution
+	at label FIXUP instead of panicking.  Both are given as
+	assembler symbols, e.g. "1b". */
+#define EXCEPTION_FIXUP(INSN, FIXUP)        \
+	".pushsection __ex_table, \"a\"\n\t"     \
+	".balign 4\n\t"                          \
+	".long " INSN ", " FIXUP "\n\t"          \
+	".popsection\n\t"
+
 void exception_init(void);
 void exception_print_stats(void);
 
@@ -0,0 +1,139 @@
+#include "userprog/fdtable.h"
+
+#include "filesys/file.h"
+#include "threads/malloc.h"
+
+#include <debug.h>
+#include <stdbool.h>
+#include <string.h>
+
+/* Lowest descriptor used for files.  Lower ones are the console. */
+#define FD_FIRST 2
+
+/* Descriptors in a table's first allocation.  A multiple of 32,
+	as is every later capacity, so that the bitmap is made of
+	whole words. */
+#define FD_INITIAL_CAPACITY 32
+
+static int find_free(const struct fd_table*);
+static bool grow(struct fd_table*);
+
+/* Initializes T as an empty table, without allocating memory. */
+void fd_table_init(struct fd_table* t)
+{
+	t->files = NULL;
+	t->used = NULL;
+	t->capacity = 0;
+	t->next_free = FD_FIRST;
+}
+
+/* Gives FILE the lowest free descriptor in T, growing T if it is
+	full.  Returns the descriptor, or -1 if memory is short. */
+int fd_table_add(struct fd_table* t, struct file* file)
+{
+	int fd = find_free(t);
+
+	if (fd < 0) {
+		/* Every descriptor below the capacity is in use, so the
+			lowest free one is the first that growing adds. */
+		fd = t->capacity > 0 ? t->capacity : FD_FIRST;
+		if (!grow(t))
+			return -1;
+	}
+	t->used[fd / 32] |= 1u << (fd % 32);
+	t->files[fd] = file;
+	t->next_free = fd + 1;
+	return fd;
+}
+
+/* Returns the file open as FD in T, or a null pointer if FD is
+	not open. */
+struct file* fd_table_get(const struct fd_table* t, int fd)
+{
+	return fd >= FD_FIRST && fd < t->capacity ? t->files[fd] : NULL;
+}
+
+/* Removes FD from T and returns the file that was open as FD,
+	which the caller should close, or a null pointer if FD was not
+	open. */
+struct file* fd_table_remove(struct fd_table* t, int fd)
+{
+	struct file* file = fd_table_get(t, fd);
+
+	if (file != NULL) {
+		t->files[fd] = NULL;
+		t->used[fd / 32] &= ~(1u << (fd % 32));
+		if (fd < t->next_free)
+			t->next_free = fd;
+	}
+	return file;
+}
+
+/* Closes every file open in T and frees T's memory, leaving T
+	empty.  Visits only the descriptors in use. */
+void fd_table_destroy(struct fd_table* t)
+{
+	int w;
+
+	for (w = 0; w < t->capacity / 32; w++) {
+		uint32_t bits = t->used[w];
+
+		if (w == 0)
+			bits &= ~((1u << FD_FIRST) - 1);
+		while (bits != 0) {
+			int fd = w * 32 + __builtin_ctz(bits);
+
+			file_close(t->files[fd]);
+			bits &= bits - 1;
+		}
+	}
+	free(t->files);
+	free(t->used);
+	fd_table_init(t);
+}
+
+/* Returns the lowest free descriptor in T, or -1 if all of T's
+	capacity is in use.  Starts at the next_free hint and checks
+	32 descriptors at a time, so this is constant time unless
+	many descriptors below the hint's word are in use. */
+static int find_free(const struct fd_table* t)
+{
+	int w;
+
+	for (w = t->next_free / 32; w < t->capacity / 32; w++) {
+		uint32_t free_bits = ~t->used[w];
+
+		if (w == t->next_free / 32)
+			free_bits &= ~0u << (t->next_free % 32);
+		if (free_bits != 0)
+			return w * 32 + __builtin_ctz(free_bits);
+	}
+	return -1;
+}
+
+/* Doubles T's capacity, or gives it its initial capacity.
+	Returns true if successful, false if memory is short. */
+static bool grow(struct fd_table* t)
+{
+	int new_capacity = t->capacity > 0 ? t->capacity * 2 : FD_INITIAL_CAPACITY;
+	struct file** files;
+	uint32_t* used;
+
+	/* If the second realloc() fails, the first has only made
+		FILES larger than needed, which is harmless. */
+	files = realloc(t->files, new_capacity * sizeof *files);
+	if (files == NULL)
+		return false;
+	t->files = files;
+	used = realloc(t->used, new_capacity / 32 * sizeof *used);
+	if (used == NULL)
+		return false;
+	t->used = used;
+
+	memset(files + t->capacity, 0, (new_capacity - t->capacity) * sizeof *files);
+	memset(used + t->capacity / 32, 0, (new_capacity - t->capacity) / 32 * sizeof *used);
+	if (t->capacity == 0)
+		used[0] = (1u << FD_FIRST) - 1;
+	t->capacity = new_capacity;
+	return true;
+}
@@ -0,0 +1,28 @@
+#ifndef USERPROG_FDTABLE_H
+#define USERPROG_FDTABLE_H
+
+#include <stdint.h>
+
+struct file;
+
+/* A process's open files, indexed by file descriptor.
+
+	The arrays are allocated on the first fd_table_add() and
+	double in size as needed, so a process that opens no files
+	uses no memory for them and one that opens many is limited
+	only by memory.  Descriptors 0 and 1 are the console, never
+	files. */
+struct fd_table {
+	struct file** files; /* Open file for each descriptor, or null. */
+	uint32_t* used;		/* Bitmap of descriptors in use. */
+	int capacity;			/* Number of descriptors in the arrays. */
+	int next_free;			/* No free descriptor is below this. */
+};
+
+void fd_table_init(struct fd_table*);
+int fd_table_add(struct fd_table*, struct file*);
+struct file* fd_table_get(const struct fd_table*, int fd);
+struct file* fd_table_remove(struct fd_table*, int fd);
+void fd_table_destroy(struct fd_table*);
+
+#endif /* userprog/fdtable.h */
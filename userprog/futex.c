@@ -0,0 +1,163 @@
+#include "userprog/futex.h"
+
+#include "threads/spinlock.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "lib/user/syscall.h"
+
+#include <debug.h>
+#include <hash.h>
+#include <list.h>
+
+/* Futexes: wait queues keyed by user addresses.
+
+	A user program keeps the state of a lock or semaphore in an
+	ordinary int in its own memory and changes it with atomic
+	instructions, entering the kernel only to sleep until the int
+	changes (futex_sleep()) or to wake sleepers after changing it
+	(futex_wakeup()).  The kernel keeps no state for a futex that
+	nobody waits on.
+
+	Waiters are kept in a fixed table of buckets, chosen by
+	hashing the futex's key, each with its own spinlock.  The key
+	of a private futex is the page directory of the process and
+	the user address.  A futex in memory shared between processes
+	would instead be keyed by the shared object and the offset
+	within it, so that every mapping of it finds the same
+	waiters, but this kernel has no shared mappings yet. */
+#define FUTEX_BUCKET_CNT 64
+
+/* Identifies a futex. */
+struct futex_key {
+	const void* object; /* Page directory, or shared object. */
+	uintptr_t offset;	  /* User address, or offset in object. */
+};
+
+/* A thread blocked in futex_sleep(). */
+struct futex_waiter {
+	struct futex_key key;	/* Futex waited on. */
+	struct semaphore sema;	/* Upped by futex_wakeup(). */
+	bool woken;					/* Removed by futex_wakeup()? */
+	struct list_elem elem;	/* Element in bucket's list. */
+};
+
+/* A hash bucket of waiters. */
+struct futex_bucket {
+	struct spinlock lock; /* Protects WAITERS. */
+	struct list waiters;	 /* List of struct futex_waiter. */
+};
+
+static struct futex_bucket buckets[FUTEX_BUCKET_CNT];
+
+static struct futex_key make_key(const int* uaddr);
+static struct futex_bucket* key_bucket(const struct futex_key*);
+static bool key_equal(const struct futex_key*, const struct futex_key*);
+
+/* Initializes the futex wait queues. */
+void futex_init(void)
+{
+	int i;
+
+	for (i = 0; i < FUTEX_BUCKET_CNT; i++) {
+		spinlock_init(&buckets[i].lock, "futex");
+		list_init(&buckets[i].waiters);
+	}
+}
+
+/* If the int at user address UADDR, which must be mapped, still
+	holds EXPECTED, sleeps until futex_wakeup() is called on UADDR
+	or TIMEOUT_TICKS timer ticks pass.  A negative TIMEOUT_TICKS
+	waits forever.  Returns FUTEX_WOKEN if woken, FUTEX_AGAIN if
+	*UADDR did not hold EXPECTED, or FUTEX_TIMEDOUT if the
+	timeout passed first.
+
+	The comparison and the enqueue are done under the bucket's
+	lock, which futex_wakeup() also takes, so a wakeup issued after
+	the caller changes *UADDR cannot be missed. */
+int futex_sleep(const int* uaddr, int expected, int64_t timeout_ticks)
+{
+	struct futex_waiter w;
+	struct futex_bucket* b;
+	enum intr_level old_level;
+
+	w.key = make_key(uaddr);
+	sema_init(&w.sema, 0);
+	w.woken = false;
+	b = key_bucket(&w.key);
+
+	old_level = spin_lock(&b->lock);
+	if (*(volatile const int*) uaddr != expected) {
+		spin_unlock(&b->lock, old_level);
+		return FUTEX_AGAIN;
+	}
+	list_push_back(&b->waiters, &w.elem);
+	spin_unlock(&b->lock, old_level);
+
+	if (timeout_ticks < 0) {
+		sema_down(&w.sema);
+		return FUTEX_WOKEN;
+	}
+	if (sema_down_timeout(&w.sema, timeout_ticks))
+		return FUTEX_WOKEN;
+
+	/* Timed out, unless futex_wakeup() dequeued us in the
+		meantime, in which case its wakeup counts. */
+	old_level = spin_lock(&b->lock);
+	if (!w.woken)
+		list_remove(&w.elem);
+	spin_unlock(&b->lock, old_level);
+	return w.woken ? FUTEX_WOKEN : FUTEX_TIMEDOUT;
+}
+
+/* Wakes up to CNT threads waiting in futex_sleep() on user
+	address UADDR, oldest first.  Returns the number woken. */
+int futex_wakeup(const int* uaddr, int cnt)
+{
+	struct futex_key key = make_key(uaddr);
+	struct futex_bucket* b = key_bucket(&key);
+	enum intr_level old_level;
+	struct list_elem* e;
+	int woken = 0;
+
+	old_level = spin_lock(&b->lock);
+	for (e = list_begin(&b->waiters); e != list_end(&b->waiters) && woken < cnt;) {
+		struct futex_waiter* w = list_entry(e, struct futex_waiter, elem);
+
+		if (key_equal(&w->key, &key)) {
+			e = list_remove(e);
+			w->woken = true;
+			sema_up(&w->sema);
+			woken++;
+		} else
+			e = list_next(e);
+	}
+	spin_unlock(&b->lock, old_level);
+
+	/* sema_up() does not yield with interrupts off. */
+	if (woken > 0)
+		thread_preempt();
+	return woken;
+}
+
+/* Returns the key of the futex at user address UADDR in the
+	running process. */
+static struct futex_key make_key(const int* uaddr)
+{
+	struct futex_key key;
+
+	key.object = thread_current()->pagedir;
+	key.offset = (uintptr_t) uaddr;
+	return key;
+}
+
+/* Returns the bucket for KEY. */
+static struct futex_bucket* key_bucket(const struct futex_key* key)
+{
+	return &buckets[hash_bytes(key, sizeof *key) % FUTEX_BUCKET_CNT];
+}
+
+/* Returns true if A and B identify the same futex. */
+static bool key_equal(const struct futex_key* a, const struct futex_key* b)
+{
+	return a->object == b->object && a->offset == b->offset;
+}
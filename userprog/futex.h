@@ -0,0 +1,10 @@
+#ifndef USERPROG_FUTEX_H
+#define USERPROG_FUTEX_H
+
+#include <stdint.h>
+
+void futex_init(void);
+int futex_sleep(const int* uaddr, int expected, int64_t timeout_ticks);
+int futex_wakeup(const int* uaddr, int cnt);
+
+#endif /* userprog/futex.h */
@@ -5,11 +5,13 @@
 #include "threads/flags.h"
 #include "threads/init.h"
 #include "threads/interrupt.h"
+#include "threads/malloc.h"
 #include "threads/palloc.h"
 #include "threads/thread.h"
 #include "threads/vaddr.h"
 #include "userprog/gdt.h"
 #include "userprog/pagedir.h"
+#include "userprog/syscall.h"
 #include "userprog/tss.h"
 #include "threads/synch.h"
 
@@ -50,7 +52,7 @@ tid_t process_execute(const char* cmd_line)
        t->pc->thread = t;
        t->pc->parent = NULL;
 
-       lock_init(&t->pc->lock);
+       lock_init_named(&t->pc->lock, "parent_child");
        sema_init(&t->pc->exit_sema, 0);
        list_init(&t->pc->children);
    }
@@ -88,6 +90,10 @@ static void start_process(void* td_)
 
    struct thread* t = thread_current();
 
+   /* Each process shares the CPU as a group with any threads it
+      creates.  If this fails, we simply stay in our parent's. */
+   thread_new_sched_group();
+
    struct parent_child *pc = malloc(sizeof(struct parent_child));
    t->pc = pc;
    t->pc->exited = false;
@@ -98,7 +104,7 @@ static void start_process(void* td_)
    t->pc->parent = NULL;
 
 
-   lock_init(&t->pc->lock);
+   lock_init_named(&t->pc->lock, "parent_child");
    sema_init(&t->pc->exit_sema, 0);
 
    list_init(&t->pc->children);
@@ -120,7 +126,9 @@ static void start_process(void* td_)
    char* save_ptr;
    char* file_name = strtok_r(cmd_line, " ", &save_ptr);
 
+   lock_acquire(&filesys_lock);
    success = load(file_name, &if_.eip, &if_.esp);
+   lock_release(&filesys_lock);
 
    /* If load failed, quit. */
    t->pc->loaded = success;
@@ -249,14 +257,30 @@ void process_exit(void)
    struct thread* t = thread_current();
    uint32_t* pd;
    
-   for(int i = 2; i< 130; i++){
-       if(t->fd_list[i] != NULL){
-           file_close(t->fd_list[i]);
-           t->fd_list[i] = NULL;
-       }
-   }
+   lock_acquire(&filesys_lock);
+   fd_table_destroy(&t->fds);
+   lock_release(&filesys_lock);
 
    printf("%s: exit(%d)\n", t->name, t->pc->exit_status);
+   syscall_process_exit();
+
+   /* Destroy the current process's page directory and switch back
+       to the kernel-only page directory.  Do it before the parent
+       can learn of our exit, so that a parent that waits for us
+       can count on having our pages back. */
+   pd = t->pagedir;
+   if (pd != NULL) {
+       /* Correct ordering here is crucial.  We must set
+           cur->pagedir to NULL before switching page directories,
+           so that a timer interrupt can't switch back to the
+           process page directory.  We must activate the base page
+           directory before destroying the process's page
+           directory, or our active page directory will be one
+           that's been freed (and cleared). */
+       t->pagedir = NULL;
+       pagedir_activate(NULL);
+       pagedir_destroy(pd);
+   }
 
    lock_acquire(&t->pc->parent->lock);
    t->pc->parent->alive_count--;
@@ -286,22 +310,6 @@ void process_exit(void)
        free(p);
      }
    }
-
-   /* Destroy the current process's page directory and switch back
-       to the kernel-only page directory. */
-   pd = t->pagedir;
-   if (pd != NULL) {
-       /* Correct ordering here is crucial.  We must set
-           cur->pagedir to NULL before switching page directories,
-           so that a timer interrupt can't switch back to the
-           process page directory.  We must activate the base page
-           directory before destroying the process's page
-           directory, or our active page directory will be one
-           that's been freed (and cleared). */
-       t->pagedir = NULL;
-       pagedir_activate(NULL);
-       pagedir_destroy(pd);
-   }
 }
 
 /* Sets up the CPU for running user code in the current
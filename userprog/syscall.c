@@ -1,20 +1,28 @@
 #include "userprog/syscall.h"
 
+#include "userprog/futex.h"
 #include "userprog/pagedir.h"
 #include "userprog/process.h"
+#include "userprog/usercopy.h"
 #include "devices/shutdown.h"
 #include "devices/input.h"
 #include "devices/timer.h"
 #include "threads/interrupt.h"
+#include "threads/malloc.h"
+#include "threads/palloc.h"
+#include "threads/synch.h"
 #include "threads/thread.h"
 #include "threads/vaddr.h"
 #include "threads/init.h"
+#include "threads/trace.h"
 #include "filesys/filesys.h"
 #include "filesys/file.h"
 #include "lib/kernel/stdio.h"
 #include "lib/user/syscall.h"
 
+#include <inttypes.h>
 #include <stdio.h>
+#include <string.h>
 #include <syscall-nr.h>
 
 static void syscall_handler(struct intr_frame*);
@@ -27,148 +35,306 @@ static unsigned tell_handler(int fd);
 static int filesize_handler(int fd);
 static int read_handler(int fd, void *buffer, unsigned size);
 static int write_handler(int fd, const void *buffer, unsigned size);
+static int rw_vector_handler(int fd, const struct iovec *uiov, int cnt, bool write);
+static int pread_handler(int fd, void *buffer, unsigned size, unsigned offset);
+static int pwrite_handler(int fd, const void *buffer, unsigned size, unsigned offset);
 static pid_t exec_handler(char *cmd_line);
 static int wait_handler(int pid);
-
-
-bool valid_pointer(void *ptr);
-bool valid_string(char *str);
-bool valid_buffer(void *buf, unsigned size);
+static int nanosleep_handler(const struct timespec *req);
+static int clock_gettime_handler(struct timespec *tp);
+static int futex_wait_handler(const int *addr, int expected, const struct timespec *timeout);
+static bool get_user_string(const char *ustr, char **str);
+
+/* Most arguments any system call takes. */
+#define SYSCALL_MAX_ARGS 4
+
+/* Most buffers readv() and writev() accept. */
+#define IOV_MAX 1024
+
+/* Number of iovecs that readv() and writev() copy in at a time. */
+#define IOV_BATCH 16
+
+/* Kinds of system call arguments.  syscall_handler() fetches and
+   checks each argument according to its kind once, before
+   calling the handler. */
+enum arg_kind {
+    ARG_INT,        /* Any value. */
+    ARG_FD,         /* File descriptor, not negative. */
+    ARG_STRING,     /* User string, passed as a kernel copy, or
+                       as NULL if it does not fit in a page. */
+    ARG_BUFFER,     /* User buffer that the kernel reads, with
+                       its size in the next argument. */
+    ARG_OUT_BUFFER, /* User buffer that the kernel writes, with
+                       its size in the next argument. */
+    ARG_USER_PTR    /* User pointer that the handler copies
+                       through itself. */
+};
+
+/* How a system call's result shows failure, for statistics. */
+enum ret_kind {
+    RET_NONE,       /* Cannot fail. */
+    RET_INT,        /* Negative on failure. */
+    RET_BOOL        /* Zero on failure. */
+};
+
+/* A system call handler.  ARGS holds the arguments, fetched and
+   checked according to their declared kinds.  Returns the value
+   for the caller's eax. */
+typedef int syscall_func(uint32_t *args);
+
+/* A system call. */
+struct syscall {
+    const char *name;                       /* Name, for statistics. */
+    syscall_func *func;                     /* Handler. */
+    enum ret_kind ret;                      /* How failure shows. */
+    int argc;                               /* Number of arguments. */
+    enum arg_kind kinds[SYSCALL_MAX_ARGS];  /* Kind of each argument. */
+    struct syscall_stat stat;               /* System-wide statistics. */
+};
+
+static syscall_func sys_sleep, sys_halt, sys_exit, sys_exec, sys_wait;
+static syscall_func sys_create, sys_remove, sys_open, sys_filesize, sys_read;
+static syscall_func sys_write, sys_seek, sys_tell, sys_close;
+static syscall_func sys_nanosleep, sys_clock_gettime, sys_futex_wait, sys_futex_wake;
+static syscall_func sys_stats, sys_readv, sys_writev, sys_pread, sys_pwrite;
+
+/* System calls, indexed by number.  Numbers without a handler
+   fail with -1. */
+static struct syscall syscalls[] = {
+    [SYS_SLEEP] = {"sleep", sys_sleep, RET_NONE, 1, {ARG_INT}},
+    [SYS_HALT] = {"halt", sys_halt, RET_NONE, 0, {}},
+    [SYS_EXIT] = {"exit", sys_exit, RET_NONE, 1, {ARG_INT}},
+    [SYS_EXEC] = {"exec", sys_exec, RET_INT, 1, {ARG_STRING}},
+    [SYS_WAIT] = {"wait", sys_wait, RET_INT, 1, {ARG_INT}},
+    [SYS_CREATE] = {"create", sys_create, RET_BOOL, 2, {ARG_STRING, ARG_INT}},
+    [SYS_REMOVE] = {"remove", sys_remove, RET_BOOL, 1, {ARG_STRING}},
+    [SYS_OPEN] = {"open", sys_open, RET_INT, 1, {ARG_STRING}},
+    [SYS_FILESIZE] = {"filesize", sys_filesize, RET_INT, 1, {ARG_FD}},
+    [SYS_READ] = {"read", sys_read, RET_INT, 3, {ARG_FD, ARG_OUT_BUFFER, ARG_INT}},
+    [SYS_WRITE] = {"write", sys_write, RET_INT, 3, {ARG_FD, ARG_BUFFER, ARG_INT}},
+    [SYS_SEEK] = {"seek", sys_seek, RET_NONE, 2, {ARG_FD, ARG_INT}},
+    [SYS_TELL] = {"tell", sys_tell, RET_INT, 1, {ARG_FD}},
+    [SYS_CLOSE] = {"close", sys_close, RET_NONE, 1, {ARG_FD}},
+    [SYS_NANOSLEEP] = {"nanosleep", sys_nanosleep, RET_INT, 1, {ARG_USER_PTR}},
+    [SYS_CLOCK_GETTIME] = {"clock_gettime", sys_clock_gettime, RET_INT, 1, {ARG_USER_PTR}},
+    [SYS_FUTEX_WAIT] = {"futex_wait", sys_futex_wait, RET_INT, 3, {ARG_USER_PTR, ARG_INT, ARG_USER_PTR}},
+    [SYS_FUTEX_WAKE] = {"futex_wake", sys_futex_wake, RET_INT, 2, {ARG_USER_PTR, ARG_INT}},
+    [SYS_STATS] = {"stats", sys_stats, RET_INT, 3, {ARG_INT, ARG_USER_PTR, ARG_INT}},
+    [SYS_READV] = {"readv", sys_readv, RET_INT, 3, {ARG_FD, ARG_USER_PTR, ARG_INT}},
+    [SYS_WRITEV] = {"writev", sys_writev, RET_INT, 3, {ARG_FD, ARG_USER_PTR, ARG_INT}},
+    [SYS_PREAD] = {"pread", sys_pread, RET_INT, 4, {ARG_FD, ARG_OUT_BUFFER, ARG_INT, ARG_INT}},
+    [SYS_PWRITE] = {"pwrite", sys_pwrite, RET_INT, 4, {ARG_FD, ARG_BUFFER, ARG_INT, ARG_INT}},
+};
+#define SYSCALL_CNT ((int) (sizeof syscalls / sizeof *syscalls))
+
+/* Print each process's system call statistics when it exits?
+   Set by kernel command-line option "-sysstats". */
+bool syscall_exit_stats;
+
+/* Serializes calls into the file system, which has no locking of
+   its own, among processes that may run on different CPUs. */
+struct lock filesys_lock;
 
 
 void syscall_init(void) {
     intr_register_int(0x30, 3, INTR_ON, syscall_handler, "syscall");
+    lock_init_named(&filesys_lock, "filesys");
+    futex_init();
 }
 
-bool valid_pointer(void *ptr) {
-    if (ptr == NULL || !is_user_vaddr(ptr) || is_kernel_vaddr(ptr) || pagedir_get_page(thread_current()->pagedir, ptr) == NULL) return false;
-    return true;
-}
-
-bool valid_string(char *str) {
-    for (; is_user_vaddr(str) && pagedir_get_page(thread_current()->pagedir, str) != NULL; str++) {
-        if (*str == '\0') return true;
+/* Copies the string at user address USTR into a new page, which
+   the caller must free with palloc_free_page(), and stores it in
+   *STR.  Stores NULL instead if the string does not fit in a page
+   or no page is free.  Returns false if USTR is a bad pointer. */
+bool get_user_string(const char *ustr, char **str) {
+    *str = palloc_get_page(0);
+    if (*str == NULL) return true;
+
+    int len = strncpy_from_user(*str, ustr, PGSIZE);
+    if (len < 0 || len == PGSIZE) {
+        palloc_free_page(*str);
+        *str = NULL;
     }
-    return false;
-}
-
-bool valid_buffer(void *buf, unsigned size) {
-    for (unsigned i = 0; i < size; i++) {
-        if (!valid_pointer((buf + i))) return false;
-    }
-    return true;
+    return len >= 0;
 }
 
 bool create_handler(char *name, unsigned size) {
+    lock_acquire(&filesys_lock);
     bool created = filesys_create(name, (off_t)size);
+    lock_release(&filesys_lock);
     return created;
 }
 
 int open_handler(char *name) {
+    lock_acquire(&filesys_lock);
     struct file *file = filesys_open(name);
-    struct thread *ct = thread_current();
-    int fd;
-
-    if (file == NULL) return -1;
+    int fd = -1;
 
-    for (fd = 2; fd < 130; fd++) {
-        if(ct->fd_list[fd] == NULL) {
-            ct->fd_list[fd] = file;
-            return fd;
-        }
+    if (file != NULL) {
+        fd = fd_table_add(&thread_current()->fds, file);
+        if (fd < 0) file_close(file);
     }
-    return -1;
+    lock_release(&filesys_lock);
+    return fd;
 }
 
 void close_handler(int fd) {
-    if (fd < 0 || fd > 130 || fd == NULL) exit_handler(-1);
-
-    struct thread * ct = thread_current();
+    if (fd == STDIN_FILENO) exit_handler(-1);
 
-    if (fd != NULL) {
-        if (ct->fd_list[fd] != NULL) {
-            file_close(ct->fd_list[fd]);
-            ct->fd_list[fd] = NULL;
-        }
+    struct file *file = fd_table_remove(&thread_current()->fds, fd);
+    if (file != NULL) {
+        lock_acquire(&filesys_lock);
+        file_close(file);
+        lock_release(&filesys_lock);
     }
 }
 
 bool remove_handler(const char *file_name) {
-    return filesys_remove(file_name);
+    lock_acquire(&filesys_lock);
+    bool removed = filesys_remove(file_name);
+    lock_release(&filesys_lock);
+    return removed;
 }
 
 void seek_handler(int fd, unsigned position) {
-    struct thread * ct = thread_current();
-
-    if (fd < 0 || fd > 130 || fd == NULL) return -1;
-
-    struct file *file = ct->fd_list[fd];
+    struct file *file = fd_table_get(&thread_current()->fds, fd);
 
     if (position < 0 || file == NULL) exit_handler(-1);
+    lock_acquire(&filesys_lock);
     if (position <= file_length(file)) {
         file_seek(file, position);
     } else {
         file_seek(file, file_length(file));
     }
+    lock_release(&filesys_lock);
 }
 
 unsigned tell_handler(int fd) {
-    struct thread *ct = thread_current();
+    struct file *file = fd_table_get(&thread_current()->fds, fd);
 
-    if (fd < 0 || fd > 130 || fd == NULL) return -1;
-
-    struct file *file = ct->fd_list[fd];
+    if (file == NULL) return -1;
+    lock_acquire(&filesys_lock);
     unsigned pos = file_tell(file);
+    lock_release(&filesys_lock);
     return pos;
 }
 
 int filesize_handler(int fd) {
-    struct thread *ct = thread_current();
-
-    if (fd < 0 || fd > 130 || fd == NULL) return -1;
+    struct file *file = fd_table_get(&thread_current()->fds, fd);
 
-    struct file *file = ct->fd_list[fd];
+    if (file == NULL) return -1;
+    lock_acquire(&filesys_lock);
     int size = file_length(file);
+    lock_release(&filesys_lock);
     return size;
 }
 
 int write_handler(int fd, const void *buffer, unsigned size) {
-    if (fd < 0 || fd > 130 || fd == NULL) return -1;
-
-    if (fd == 1) {
+    if (fd == STDOUT_FILENO) {
         putbuf(buffer, size);
         return size;
-    } else if (fd != NULL) {
-        struct thread * ct = thread_current();
-        struct file * file = ct->fd_list[fd];
-        if (file == NULL) return -1;
-
-        int written_size = file_write(file, buffer, size);
-        if (written_size != 0) return written_size; 
-    } else if (fd == 0) {
-        exit_handler(-1);
     }
+
+    struct file *file = fd_table_get(&thread_current()->fds, fd);
+    if (file == NULL) return -1;
+    lock_acquire(&filesys_lock);
+    int written = file_write(file, buffer, size);
+    lock_release(&filesys_lock);
+    return written;
 }
 
 int read_handler(int fd, void *buffer, unsigned size) {
-    struct thread *ct = thread_current();
+    if (fd == STDIN_FILENO) {
+        for (unsigned i = 0; i < size; i++) {
+            ((uint8_t*) buffer)[i] = input_getc();
+        }
+        return size;
+    }
 
-    if (fd < 0 || fd > 130 || fd == NULL) return -1;
+    struct file *file = fd_table_get(&thread_current()->fds, fd);
+    if (file == NULL) return -1;
+    lock_acquire(&filesys_lock);
+    int read = file_read(file, buffer, size);
+    lock_release(&filesys_lock);
+    return read;
+}
 
-    if (fd == 0) {
-        for (int i=0; i<size; i++) {
-            buffer = *((int**)input_getc());
-            buffer++;
+/* Reads from FD into the buffers described by the CNT iovecs at
+   user address UIOV, or writes them to FD if WRITE is true, in
+   order, stopping after a short transfer.  Returns the number of
+   bytes transferred, or -1 if FD is not open or CNT is out of
+   range. */
+int rw_vector_handler(int fd, const struct iovec *uiov, int cnt, bool write) {
+    struct iovec iov[IOV_BATCH];
+    int total = 0;
+
+    if (cnt < 0 || cnt > IOV_MAX) return -1;
+    if (fd != (write ? STDOUT_FILENO : STDIN_FILENO) && fd_table_get(&thread_current()->fds, fd) == NULL) return -1;
+
+    for (int i = 0; i < cnt; i++) {
+        if (i % IOV_BATCH == 0) {
+            int batch = cnt - i < IOV_BATCH ? cnt - i : IOV_BATCH;
+            if (!copy_from_user(iov, uiov + i, batch * sizeof *iov)) exit_handler(-1);
         }
-        return size;
-    } else if (fd == 1){
-        return -1;
-    } else {
-        if (ct->fd_list[fd] == NULL) return -1;
-        int read_size = (int)file_read(ct->fd_list[fd], buffer, size);
-        return read_size;
+
+        const struct iovec *v = &iov[i % IOV_BATCH];
+        int done;
+        if (write) {
+            if (!user_range_readable(v->iov_base, v->iov_len)) exit_handler(-1);
+            done = write_handler(fd, v->iov_base, v->iov_len);
+        } else {
+            if (!user_range_writable(v->iov_base, v->iov_len)) exit_handler(-1);
+            done = read_handler(fd, v->iov_base, v->iov_len);
+        }
+        if (done < 0) return total > 0 ? total : -1;
+        total += done;
+        if ((size_t) done < v->iov_len) break;
+    }
+    return total;
+}
+
+int pread_handler(int fd, void *buffer, unsigned size, unsigned offset) {
+    struct file *file = fd_table_get(&thread_current()->fds, fd);
+
+    if (file == NULL || (off_t) offset < 0) return -1;
+    lock_acquire(&filesys_lock);
+    int read = file_read_at(file, buffer, size, offset);
+    lock_release(&filesys_lock);
+    return read;
+}
+
+int pwrite_handler(int fd, const void *buffer, unsigned size, unsigned offset) {
+    struct file *file = fd_table_get(&thread_current()->fds, fd);
+
+    if (file == NULL || (off_t) offset < 0) return -1;
+    lock_acquire(&filesys_lock);
+    int written = file_write_at(file, buffer, size, offset);
+    lock_release(&filesys_lock);
+    return written;
+}
+
+int nanosleep_handler(const struct timespec *req) {
+    if (req->tv_sec < 0 || req->tv_nsec < 0 || req->tv_nsec >= 1000000000) return -1;
+    timer_hrsleep((int64_t) req->tv_sec * 1000000000 + req->tv_nsec);
+    return 0;
+}
+
+int clock_gettime_handler(struct timespec *tp) {
+    int64_t ns = timer_ns();
+    tp->tv_sec = ns / 1000000000;
+    tp->tv_nsec = ns % 1000000000;
+    return 0;
+}
+
+int futex_wait_handler(const int *addr, int expected, const struct timespec *timeout) {
+    int64_t ticks = -1;
+
+    if (timeout != NULL) {
+        if (timeout->tv_sec < 0 || timeout->tv_nsec < 0 || timeout->tv_nsec >= 1000000000) return FUTEX_INVALID;
+        /* Round up, so that we never wake early. */
+        ticks = (int64_t) timeout->tv_sec * TIMER_FREQ + ((int64_t) timeout->tv_nsec * TIMER_FREQ + 999999999) / 1000000000;
     }
-    return -1;
+    return futex_sleep(addr, expected, ticks);
 }
 
 pid_t exec_handler(char *cmd_line) {
@@ -178,145 +344,265 @@ pid_t exec_handler(char *cmd_line) {
 }
 
 int exit_handler(int status) {
-    for (int i=2; i<130; i++){
-        close_handler(i);
-    }
-
     struct thread *ct = thread_current();
     ct->pc->exit_status = status;
 
     thread_exit();
 }
 
-static void syscall_handler(struct intr_frame *f) {
-    if (!valid_pointer(f->esp)) exit_handler(-1);
-    if (!valid_pointer(f->esp + 4)) exit_handler(-1);
-    if (!valid_pointer(f->esp + 1)) exit_handler(-1);
-
-    int fd = -1;
-    char *str = NULL;
-    void *buf = NULL;
-    unsigned size = 0;
-    int syscall_nr = *((int*)f->esp);
-
-    switch (syscall_nr) {
-        case SYS_SLEEP: {
-            if (!valid_pointer(f->esp + 4)) exit_handler(-1);
-            int millis = *(int*) (f->esp + 4);
-            int64_t ticks = (int64_t)TIMER_FREQ * millis / 1000;
-            timer_sleep(ticks);
-            break;
+/* Fetches the arguments of system call SC, made with interrupt
+   frame F, into ARGS, and checks and converts them according to
+   their kinds.  Kills the process if an argument is a bad
+   pointer.  Returns false if an argument is out of range, in
+   which case no string has been copied. */
+static bool fetch_args(struct intr_frame *f, const struct syscall *sc, uint32_t *args) {
+    if (!copy_from_user(args, (uint32_t*) f->esp + 1, sc->argc * sizeof *args)) exit_handler(-1);
+
+    for (int i = 0; i < sc->argc; i++) {
+        switch (sc->kinds[i]) {
+            case ARG_FD:
+                if ((int) args[i] < 0) return false;
+                break;
+            case ARG_BUFFER:
+                if (!user_range_readable((void*) args[i], args[i + 1])) exit_handler(-1);
+                break;
+            case ARG_OUT_BUFFER:
+                if (!user_range_writable((void*) args[i], args[i + 1])) exit_handler(-1);
+                break;
+            default:
+                break;
         }
+    }
 
-        case SYS_HALT: { 
-            shutdown_power_off();
-            break;
+    /* Copy strings last, so that nothing needs freeing above. */
+    for (int i = 0; i < sc->argc; i++) {
+        if (sc->kinds[i] != ARG_STRING) continue;
+        char *str;
+        if (!get_user_string((const char*) args[i], &str)) {
+            while (--i >= 0) {
+                if (sc->kinds[i] == ARG_STRING) palloc_free_page((void*) args[i]);
+            }
+            exit_handler(-1);
         }
+        args[i] = (uint32_t) str;
+    }
+    return true;
+}
 
-        case SYS_CREATE: {
-            if (!valid_pointer(f->esp + 4)) exit_handler(-1);
-            if (!valid_pointer(f->esp + 8)) exit_handler(-1);
-            if (!valid_string(f->esp + 4)) exit_handler(-1);
-            str = *(char**) (f->esp + 4);
-            size = *(unsigned*) (f->esp + 8);
-            if (!valid_string(str)) exit_handler(-1);
-            f->eax = create_handler(str, size);
-            break;
-        }
+/* Frees the strings that fetch_args() copied for SC into ARGS. */
+static void release_args(const struct syscall *sc, uint32_t *args) {
+    for (int i = 0; i < sc->argc; i++) {
+        if (sc->kinds[i] == ARG_STRING) palloc_free_page((void*) args[i]);
+    }
+}
 
-        case SYS_OPEN: {
-            if (!valid_pointer((f->esp + 4))) exit_handler(-1);
-            if (!valid_string(f->esp + 4)) exit_handler(-1);
-            str = *(char**)(f->esp + 4);
-            if (!valid_string(str)) exit_handler(-1);
-            f->eax = open_handler(str);
-            break;
-        }
+/* Adds a call that took NS nanoseconds and failed if FAILED to
+   statistics ST. */
+static void record_stat(struct syscall_stat *st, uint64_t ns, bool failed) {
+    uint64_t us = ns / 1000;
+    int bucket = us == 0 ? 0 : us >= 1u << (SYSCALL_HIST_CNT - 1) ? SYSCALL_HIST_CNT - 1 : 32 - __builtin_clz(us);
 
-        case SYS_CLOSE: {
-            if (!valid_pointer(f->esp + 4)) exit_handler(-1);
-            fd = *(int*) (f->esp + 4);
-            close_handler(fd);
-            break;
-        }
+    st->calls++;
+    st->errors += failed;
+    st->ns += ns;
+    st->hist[bucket]++;
+}
 
-        case SYS_REMOVE: {
-            if (!valid_pointer(f->esp + 4)) exit_handler(-1);
-            if (!valid_string(f->esp + 4)) exit_handler(-1);
-            str = *(char**) (f->esp + 4);
-            if (!valid_string(str)) exit_handler(-1);
-            f->eax = remove_handler(str);
-            break;
-        }
+static void syscall_handler(struct intr_frame *f) {
+    uint32_t args[SYSCALL_MAX_ARGS];
+    int syscall_nr;
 
-        case SYS_SEEK: {
-            if (!valid_pointer(f->esp + 4)) exit_handler(-1);
-            if (!valid_pointer(f->esp + 8)) exit_handler(-1);
-            fd = *(int*) (f->esp + 4);
-            unsigned position = *(unsigned*) (f->esp + 8);
-            seek_handler(fd, position);
-            break;
-        }
+    if (!copy_from_user(&syscall_nr, f->esp, sizeof syscall_nr)) exit_handler(-1);
+    TRACE(TRACE_SYSCALL_ENTER, syscall_nr, 0);
 
-        case SYS_TELL: {
-            if (!valid_pointer(f->esp + 4)) exit_handler(-1);
-            fd = *(int*) (f->esp + 4);
-            f->eax = tell_handler(fd);
-            break;
+    if (syscall_nr < 0 || syscall_nr >= SYSCALL_CNT || syscalls[syscall_nr].func == NULL) {
+        f->eax = -1;
+    } else {
+        struct syscall *sc = &syscalls[syscall_nr];
+        struct thread *t = thread_current();
+        uint64_t start = timer_cycles();
+        bool failed;
+
+        /* Count exit() before it runs, since it does not return. */
+        if (syscall_nr == SYS_EXIT) {
+            enum intr_level old_level = intr_disable();
+            record_stat(&sc->stat, 0, false);
+            if (t->syscall_stats != NULL) record_stat(&t->syscall_stats[syscall_nr], 0, false);
+            intr_set_level(old_level);
         }
 
-        case SYS_FILESIZE: {
-            if (!valid_pointer(f->esp + 4)) exit_handler(-1);
-            fd = *(int*) (f->esp + 4);
-            f->eax = filesize_handler(fd);
-            break;
+        if (fetch_args(f, sc, args)) {
+            f->eax = sc->func(args);
+            release_args(sc, args);
+            failed = (sc->ret == RET_INT && (int) f->eax < 0) || (sc->ret == RET_BOOL && f->eax == 0);
+        } else {
+            f->eax = -1;
+            failed = true;
         }
 
-        case SYS_READ: {
-            if (!valid_pointer(f->esp + 4)) exit_handler(-1);
-            if (!valid_pointer(f->esp + 8)) exit_handler(-1);
-            if (!valid_pointer(f->esp + 12)) exit_handler(-1);
-            fd = *(int*) (f->esp + 4);
-            buf = *(void**) (f->esp + 8);
-            size = *(unsigned*) (f->esp + 12);
-            if (!valid_buffer(buf, size)) exit_handler(-1);
-            f->eax = read_handler(fd, buf, size);
-            break;
-        }
+        /* Statistics are shared with other processes, so keep out
+           their updates. */
+        uint64_t ns = timer_cycles_to_ns(timer_cycles() - start);
+        if (t->syscall_stats == NULL) t->syscall_stats = calloc(SYSCALL_CNT, sizeof *t->syscall_stats);
+        enum intr_level old_level = intr_disable();
+        record_stat(&sc->stat, ns, failed);
+        if (t->syscall_stats != NULL) record_stat(&t->syscall_stats[syscall_nr], ns, failed);
+        intr_set_level(old_level);
+    }
+    TRACE(TRACE_SYSCALL_EXIT, syscall_nr, f->eax);
+}
 
-        case SYS_WRITE: {
-            if (!valid_pointer(f->esp + 4)) exit_handler(-1);
-            if (!valid_pointer(f->esp + 8)) exit_handler(-1);
-            if (!valid_pointer(f->esp + 12)) exit_handler(-1);
-            fd = *(int*) (f->esp + 4);
-            buf = *(void**) (f->esp + 8);
-            size = *(unsigned*) (f->esp + 12);
-            if (!valid_buffer(buf, size)) exit_handler(-1);
-            f->eax = write_handler(fd, buf, size);
-            break;
-        }
+/* Prints statistics ST for system call number NR, if it was
+   used. */
+static void print_stat(int nr, const struct syscall_stat *st) {
+    if (st->calls == 0) return;
+    printf("Syscall: %s: %u calls, %u errors, %"PRIu64" us\n", syscalls[nr].name, st->calls, st->errors, st->ns / 1000);
+}
 
-        case SYS_EXIT: {
-            if (!valid_pointer(f->esp + 4)) exit_handler(-1);
-            fd = *(int*) (f->esp + 4);
-            f->eax = exit_handler(fd);
-            break;
-        }
+/* Prints the system-wide system call statistics. */
+void syscall_print_stats(void) {
+    for (int i = 0; i < SYSCALL_CNT; i++) print_stat(i, &syscalls[i].stat);
+}
 
-        case SYS_EXEC: {
-            if (!valid_pointer(f->esp + 4)) exit_handler(-1);
-            if (!valid_string(f->esp + 4)) exit_handler(-1);
-            str = *(char**) (f->esp + 4);
-            if (!valid_string(str)) exit_handler(-1);
-            f->eax = process_execute(str);
-            break;
-        }
+/* Prints the running process's system call statistics if
+   syscall_exit_stats is set, then frees them.  Called by
+   process_exit(). */
+void syscall_process_exit(void) {
+    struct thread *t = thread_current();
 
-        case SYS_WAIT: {
-            if (!valid_pointer(f->esp + 4)) exit_handler(-1);
-            tid_t tid = *(int*) (f->esp + 4);
-            f->eax = process_wait(tid);
-            break;
-        }
+    if (t->syscall_stats == NULL) return;
+    if (syscall_exit_stats) {
+        printf("Syscall statistics for %s:\n", t->name);
+        for (int i = 0; i < SYSCALL_CNT; i++) print_stat(i, &t->syscall_stats[i]);
     }
+    free(t->syscall_stats);
+    t->syscall_stats = NULL;
+}
+
+int sys_sleep(uint32_t *args) {
+    int millis = args[0];
+    timer_sleep((int64_t) TIMER_FREQ * millis / 1000);
+    return 0;
+}
+
+int sys_halt(uint32_t *args UNUSED) {
+    shutdown_power_off();
+}
+
+int sys_exit(uint32_t *args) {
+    return exit_handler(args[0]);
+}
+
+int sys_exec(uint32_t *args) {
+    char *cmd_line = (char*) args[0];
+    return cmd_line != NULL ? process_execute(cmd_line) : -1;
+}
+
+int sys_wait(uint32_t *args) {
+    return process_wait(args[0]);
+}
+
+int sys_create(uint32_t *args) {
+    char *name = (char*) args[0];
+    return name != NULL && create_handler(name, args[1]);
+}
+
+int sys_remove(uint32_t *args) {
+    char *name = (char*) args[0];
+    return name != NULL && remove_handler(name);
+}
+
+int sys_open(uint32_t *args) {
+    char *name = (char*) args[0];
+    return name != NULL ? open_handler(name) : -1;
+}
+
+int sys_filesize(uint32_t *args) {
+    return filesize_handler(args[0]);
+}
+
+int sys_read(uint32_t *args) {
+    return read_handler(args[0], (void*) args[1], args[2]);
+}
+
+int sys_write(uint32_t *args) {
+    return write_handler(args[0], (const void*) args[1], args[2]);
+}
+
+int sys_seek(uint32_t *args) {
+    seek_handler(args[0], args[1]);
+    return 0;
+}
+
+int sys_tell(uint32_t *args) {
+    return tell_handler(args[0]);
+}
+
+int sys_close(uint32_t *args) {
+    close_handler(args[0]);
+    return 0;
+}
+
+int sys_nanosleep(uint32_t *args) {
+    struct timespec req;
+    if (!copy_from_user(&req, (void*) args[0], sizeof req)) exit_handler(-1);
+    return nanosleep_handler(&req);
+}
+
+int sys_clock_gettime(uint32_t *args) {
+    struct timespec tp;
+    int result = clock_gettime_handler(&tp);
+    if (!copy_to_user((void*) args[0], &tp, sizeof tp)) exit_handler(-1);
+    return result;
+}
+
+int sys_futex_wait(uint32_t *args) {
+    const int *addr = (const int*) args[0];
+    struct timespec timeout;
+
+    if ((uintptr_t) addr % sizeof(int) != 0 || !user_range_readable(addr, sizeof(int))) exit_handler(-1);
+    if (args[2] == 0) return futex_wait_handler(addr, args[1], NULL);
+    if (!copy_from_user(&timeout, (void*) args[2], sizeof timeout)) exit_handler(-1);
+    return futex_wait_handler(addr, args[1], &timeout);
+}
+
+int sys_futex_wake(uint32_t *args) {
+    const int *addr = (const int*) args[0];
+
+    if ((uintptr_t) addr % sizeof(int) != 0 || !user_range_readable(addr, sizeof(int))) exit_handler(-1);
+    return futex_wakeup(addr, args[1]);
+}
+
+int sys_stats(uint32_t *args) {
+    struct syscall_stat *ustats = (struct syscall_stat*) args[1];
+    int cnt = (int) args[2] < SYSCALL_CNT ? (int) args[2] : SYSCALL_CNT;
+    struct thread *t = thread_current();
+
+    if (args[0] != STATS_PROCESS && args[0] != STATS_SYSTEM) return -1;
+    for (int i = 0; i < cnt; i++) {
+        struct syscall_stat st;
+
+        if (args[0] == STATS_SYSTEM) st = syscalls[i].stat;
+        else if (t->syscall_stats != NULL) st = t->syscall_stats[i];
+        else memset(&st, 0, sizeof st);
+        strlcpy(st.name, syscalls[i].name != NULL ? syscalls[i].name : "", sizeof st.name);
+        if (!copy_to_user(&ustats[i], &st, sizeof st)) exit_handler(-1);
+    }
+    return SYSCALL_CNT;
+}
+
+int sys_readv(uint32_t *args) {
+    return rw_vector_handler(args[0], (const struct iovec*) args[1], args[2], false);
+}
+
+int sys_writev(uint32_t *args) {
+    return rw_vector_handler(args[0], (const struct iovec*) args[1], args[2], true);
+}
+
+int sys_pread(uint32_t *args) {
+    return pread_handler(args[0], (void*) args[1], args[2], args[3]);
+}
+
+int sys_pwrite(uint32_t *args) {
+    return pwrite_handler(args[0], (const void*) args[1], args[2], args[3]);
 }
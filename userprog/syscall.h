@@ -1,6 +1,19 @@
 #ifndef USERPROG_SYSCALL_H
 #define USERPROG_SYSCALL_H
 
+#include "threads/synch.h"
+
+#include <stdbool.h>
+
+/* Print each process's system call statistics when it exits? */
+extern bool syscall_exit_stats;
+
+/* Held around every call into the file system on behalf of a
+   user process. */
+extern struct lock filesys_lock;
+
 void syscall_init(void);
+void syscall_print_stats(void);
+void syscall_process_exit(void);
 
 #endif /* userprog/syscall.h */
@@ -0,0 +1,151 @@
+#include "userprog/usercopy.h"
+
+#include "threads/vaddr.h"
+#include "userprog/exception.h"
+
+#include <stdint.h>
+
+/* Access to user memory from system calls.
+
+	Rather than looking up every user address in the page
+	directory before touching it, these routines access user
+	memory directly, optimistically, through instructions listed
+	in the exception fixup table.  If one of them faults, because
+	the user address is unmapped or, for a write, read-only,
+	page_fault() resumes it at its fixup, which reports failure.
+	Only the check that the address lies below PHYS_BASE has to be
+	done in advance, since kernel addresses are always mapped. */
+
+/* Returns true if the SIZE bytes starting at UADDR all lie in
+	user virtual memory. */
+static bool is_user_range(const void* uaddr, size_t size)
+{
+	uintptr_t start = (uintptr_t) uaddr;
+
+	return start + size >= start && start + size <= (uintptr_t) PHYS_BASE;
+}
+
+/* Copies SIZE bytes from SRC to DST, either of which may be a
+	user address.  Returns the number of bytes left uncopied
+	because of a fault: zero if successful. */
+static size_t copy_raw(void* dst, const void* src, size_t size)
+{
+	/* `rep movsb' faults with ECX holding the count of bytes not
+		yet copied, which the fixup leaves for us. */
+	asm volatile("1: rep movsb\n"
+					 "2:\n" EXCEPTION_FIXUP("1b", "2b")
+					 : "+D"(dst), "+S"(src), "+c"(size)
+					 :
+					 : "memory");
+	return size;
+}
+
+/* Reads the byte at user address UADDR, which must be below
+	PHYS_BASE.  Returns the byte value if successful, -1 if a
+	fault occurred. */
+static inline int get_user(const uint8_t* uaddr)
+{
+	int result = -1;
+
+	asm volatile("1: movzbl %1, %0\n"
+					 "2:\n" EXCEPTION_FIXUP("1b", "2b")
+					 : "+r"(result)
+					 : "m"(*uaddr));
+	return result;
+}
+
+/* Writes BYTE to user address UDST, which must be below
+	PHYS_BASE.  Returns true if successful, false if a fault
+	occurred. */
+static inline bool put_user(uint8_t* udst, uint8_t byte)
+{
+	int ok = 0;
+
+	asm volatile("1: movb %b2, %0\n"
+					 "movl $1, %1\n"
+					 "2:\n" EXCEPTION_FIXUP("1b", "2b")
+					 : "=m"(*udst), "+r"(ok)
+					 : "q"(byte));
+	return ok;
+}
+
+/* Copies SIZE bytes from user address USRC to kernel address
+	DST.  Returns true if successful, false if any of the user
+	bytes is not mapped. */
+bool copy_from_user(void* dst, const void* usrc, size_t size)
+{
+	return is_user_range(usrc, size) && copy_raw(dst, usrc, size) == 0;
+}
+
+/* Copies SIZE bytes from kernel address SRC to user address
+	UDST.  Returns true if successful, false if any of the user
+	bytes is not mapped writable.  On failure, some bytes may have
+	been copied. */
+bool copy_to_user(void* udst, const void* src, size_t size)
+{
+	return is_user_range(udst, size) && copy_raw(udst, src, size) == 0;
+}
+
+/* Copies the null-terminated string at user address USRC,
+	including the null terminator, into DST, copying at most SIZE
+	bytes.  Returns the string's length, not counting the null
+	terminator; SIZE if no null terminator was found within SIZE
+	bytes, in which case DST is not null-terminated; or -1 if the
+	string is not in mapped user memory. */
+int strncpy_from_user(char* dst, const char* usrc, size_t size)
+{
+	size_t i;
+
+	for (i = 0; i < size; i++) {
+		int c;
+
+		if (!is_user_vaddr(usrc + i))
+			return -1;
+		c = get_user((const uint8_t*) usrc + i);
+		if (c < 0)
+			return -1;
+		dst[i] = c;
+		if (c == '\0')
+			return i;
+	}
+	return size;
+}
+
+/* Returns true if all SIZE bytes starting at user address UADDR
+	are mapped, so that the kernel may read them directly.  Checks
+	one byte per page. */
+bool user_range_readable(const void* uaddr, size_t size)
+{
+	const uint8_t* p;
+
+	if (!is_user_range(uaddr, size))
+		return false;
+	if (size == 0)
+		return true;
+	for (p = pg_round_down(uaddr); p < (const uint8_t*) uaddr + size; p += PGSIZE)
+		if (get_user(p < (const uint8_t*) uaddr ? uaddr : p) < 0)
+			return false;
+	return true;
+}
+
+/* Returns true if all SIZE bytes starting at user address UADDR
+	are mapped writable, so that the kernel may write them
+	directly.  Checks one byte per page, by writing back the value
+	it reads. */
+bool user_range_writable(void* uaddr, size_t size)
+{
+	uint8_t* p;
+
+	if (!is_user_range(uaddr, size))
+		return false;
+	if (size == 0)
+		return true;
+	for (p = pg_round_down(uaddr); p < (uint8_t*) uaddr + size; p += PGSIZE) {
+		uint8_t* q = p < (uint8_t*) uaddr ? uaddr : p;
+		int c = get_user(q);
+
+		if (c < 0 || !put_user(q, c))
+			return false;
+	}
+	return true;
+}